@@ -37,6 +37,15 @@ it is necessary to check they are correct.
 #define HAVE_TLS 0   /* have storage attribute for thread-local */
 #define TLS_ATTR   /* if so, what it is.  if not, empty */
 
+/* Compiling with -DUSE_TLS selects thread-local work areas regardless of
+   how configure set the two lines above (used by nautyTL1.a) */
+#ifdef USE_TLS
+#undef HAVE_TLS
+#undef TLS_ATTR
+#define HAVE_TLS 1
+#define TLS_ATTR __thread
+#endif
+
 #define USE_ANSICONTROLS 0 
                           /* whether --enable-ansicontrols is used */
 
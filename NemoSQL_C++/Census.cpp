@@ -0,0 +1,1107 @@
+//------------------------------------------------------------------------------
+//  Census.cpp
+//------------------------------------------------------------------------------
+// Census counts the connected size-k subgraphs of a Graph on one or more
+// threads. ESU trees of different roots are independent, so every root is a
+// task. Each worker owns an ESUEngine, a deque of ESUTasks and its own
+// counters; it pops tasks from the back of its own deque and, once that is
+// empty, steals from the front of the other workers' deques. While some
+// worker is idle, busy engines split subtrees off their stacks into their
+// own deques, so a hub root is shared out instead of finishing last. The
+// per-worker counters are merged when every worker has finished.
+//
+// A sampled census runs RAND-ESU and scales the sampled count by the inverse
+// of the probability p[1] * ... * p[k] of finding any one subgraph, with
+// the Horvitz-Thompson variance the engines accumulate, in total and by
+// class.
+//
+// Under a budget the engines charge their tree nodes to a shared counter and
+// stop their task once the budget is spent. An exact engine publishes the
+// unexpanded rest of its stack, exactly as for a checkpoint, and its count so
+// far is credited, so a continued run carries on where this one stopped. A
+// sampled engine abandons its task, which is kept whole. Every root keeps a
+// count of its outstanding tasks, so the census knows which roots finished;
+// the count of the others is predicted from the finished ones (see
+// Census.h).
+//
+// ASSUMPTIONS:
+//   -- The Graph is not modified while a census runs on it
+//   -- 2 <= k
+//
+//------------------------------------------------------------------------------
+
+#include "Census.h"
+#include "GraphCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+const int Census::CERTAIN;
+const uint32_t Census::CHECKPOINT_VERSION;
+
+//--------------------------------- Constructor --------------------------------
+// Prepare a census of the size-k subgraphs of graph on threads workers
+// Preconditions: 2 <= k
+// Postconditions: Nothing is counted until run is called. A threads value
+//                 below 1 means one worker.
+Census::Census(const Graph &graph, const int &k, const int &threads)
+    : graph(graph), k(k), workers(max(1, threads)), idle(0), nodesUsed(0),
+      stopped(false)
+{}
+
+//---------------------------------- Destructor --------------------------------
+// Destructor for class Census
+// Preconditions: None
+// Postconditions: None
+Census::~Census()
+{}
+
+
+//------------------------------------- run ------------------------------------
+// Enumerate every size-k subgraph of the graph
+// Preconditions: None
+// Postconditions: total() and workerTotals() hold the counts of this run
+void Census::run()
+{
+    const int T = (int)workers.size();
+    const int n = graph.vertexCount();
+    
+    // classSnapshot waits until the class counts are set up
+    unique_lock<mutex> setup(snapshotLock);
+    for (int t = 0; t < T; t++)
+    {
+        workers[t].tasks.clear();
+        workers[t].count = 0;
+        workers[t].squares = 0.0;
+        workers[t].classSquares.clear();
+        workers[t].classes.clear();
+        if (classifying && k <= Classifier::CACHE_SIZE)
+            workers[t].histogram.assign(Classifier::classLimit(k));
+    }
+    
+    const bool budgeted = secondsLimit > 0.0 || nodeLimit > 0;
+    vector<ESUTask> dealt;
+    if (resumed)
+    {
+        // pending and rootTotals were restored by resume
+        dealt.swap(saved);
+        roots = 0;
+        for (int v = 0; v < n; v++)
+            roots += graph.degree(v) > 0;
+        if (budgeted)
+            stratify(nullptr);
+    }
+    else
+    {
+        allocateRoots();
+        rootCarries.clear();
+        vector<int> order;
+        for (int v = 0; v < n; v++)
+        {
+            pending[v] = 0;
+            rootTotals[v] = 0;
+            if (graph.degree(v) > 0)
+            {
+                pending[v] = 1;
+                order.push_back(v);
+            }
+        }
+        roots = (int)order.size();
+        savedSquares = 0.0;
+        savedClassSquares.clear();
+        savedClasses.clear();
+        
+        // A budget may stop the run part way: deal the roots in a stratified
+        // random order. Workers pop from the back, so it is dealt reversed.
+        if (budgeted)
+        {
+            stratify(&order);
+            reverse(order.begin(), order.end());
+        }
+        dealt.resize(roots);
+        for (int i = 0; i < roots; i++)
+            dealt[i].root = order[i];
+    }
+    resumed = false;
+    
+    // Deal the tasks round robin so that every worker starts with a mix of
+    // low roots (large ESU trees) and high roots (small ones)
+    for (size_t i = 0; i < dealt.size(); i++)
+        workers[i % T].tasks.push_back(move(dealt[i]));
+    idle = 0;
+    nodesUsed = 0;
+    stopped = false;
+    pausing = false;
+    paused = 0;
+    exited = 0;
+    finishedRun = false;
+    deadline = chrono::steady_clock::now() +
+               chrono::duration_cast<chrono::steady_clock::duration>(
+                   chrono::duration<double>(secondsLimit));
+    
+    setup.unlock();
+    
+    thread checkpoints;
+    if (!checkpointFile.empty())
+        checkpoints = thread(&Census::checkpointLoop, this);
+    vector<thread> threads;
+    for (int t = 1; t < T; t++)
+        threads.push_back(thread(&Census::work, this, t));
+    work(0);
+    for (thread &worker : threads)
+        worker.join();
+    if (checkpoints.joinable())
+    {
+        {
+            lock_guard<mutex> guard(clock);
+            finishedRun = true;
+        }
+        tick.notify_one();
+        checkpoints.join();
+    }
+    
+    merged = Counter();
+    squares = 0.0;
+    finished = 0;
+    for (int v = 0; v < n; v++)
+        if (graph.degree(v) > 0 && pending[v] == 0)
+        {
+            merged += rootCount(v);
+            finished++;
+        }
+    squares = savedSquares;
+    for (const Worker &worker : workers)
+        squares += worker.squares;
+    classes = mergeClasses();
+    classSquares = mergeClassSquares();
+    classified = 0.0;
+    for (const pair<const ClassKey, Counter> &entry : classes)
+        classified += entry.second.value();
+    
+    // A finished run needs no checkpoint; a stopped one saves where it
+    // stopped so that it can be continued
+    if (!checkpointFile.empty())
+    {
+        if (complete())
+            remove(checkpointFile.c_str());
+        else
+            writeCheckpoint();
+    }
+    
+    remainder = 0.0;
+    remainderVariance = 0.0;
+    if (!complete())
+    {
+        predict(true);
+        predict(false);
+    }
+}
+
+//--------------------------------- setSampling --------------------------------
+// Make the next runs RAND-ESU samples with the per-size probabilities
+// p[1 .. k]
+// Preconditions: p.size() == k + 1 and every p[s] is in (0, 1]; p[0] is
+//                ignored
+// Postconditions: Runs draw from generators derived from seed
+void Census::setSampling(const vector<double> &p, const uint64_t &seed)
+{
+    sampled = true;
+    probabilities = p;
+    this->seed = seed;
+}
+
+//------------------------------ setClassification -----------------------------
+// Make the next runs count subgraphs by isomorphism class too
+// Preconditions: k <= Classifier::MAX_SIZE
+// Postconditions: classCounts() holds the class counts of each run
+void Census::setClassification()
+{
+    classifying = true;
+}
+
+//---------------------------------- setBudget ---------------------------------
+// Limit the next runs to seconds of wall-clock time and to nodes ESU tree
+// nodes over all workers
+// Preconditions: None
+// Postconditions: A limit of 0 is no limit; when both are 0 runs always
+//                 complete
+void Census::setBudget(const double &seconds, const long &nodes)
+{
+    secondsLimit = max(0.0, seconds);
+    nodeLimit = max(0L, nodes);
+}
+
+//-------------------------------- setCheckpoint -------------------------------
+// Save the progress of the next runs to filename every seconds seconds
+// Preconditions: seconds > 0
+// Postconditions: The file is replaced atomically at each checkpoint
+void Census::setCheckpoint(const string &filename, const double &seconds)
+{
+    checkpointFile = filename;
+    checkpointSeconds = seconds;
+}
+
+//----------------------------------- resume -----------------------------------
+// Continue the next run from a checkpoint instead of from scratch
+// Preconditions: setClassification, if wanted, has been called
+// Postconditions: Returns false, leaving the census unchanged, if filename
+//                 could not be read, is inconsistent, or was written for
+//                 another graph, k or classification setting. Otherwise the
+//                 sampling settings are those of the checkpointed run.
+bool Census::resume(const string &filename)
+{
+    ifstream infile(filename.c_str(), ios::binary);
+    if (!infile)
+        return false;
+    
+    auto read = [&](void *data, size_t bytes)
+    {
+        return (bool)infile.read(reinterpret_cast<char *>(data),
+                                 (streamsize)bytes);
+    };
+    
+    char magic[8];
+    uint32_t version;
+    int32_t size, vertices;
+    uint64_t hash;
+    if (!read(magic, 8) || memcmp(magic, "NEMOCKP", 8) != 0 ||
+        !read(&version, sizeof(version)) || version != CHECKPOINT_VERSION ||
+        !read(&size, sizeof(size)) || size != k ||
+        !read(&vertices, sizeof(vertices)) ||
+        vertices != graph.vertexCount() ||
+        !read(&hash, sizeof(hash)) || hash != fingerprint())
+        return false;
+    
+    const int n = vertices;
+    uint8_t sampling;
+    uint64_t base;
+    double sum;
+    vector<double> p(k + 1);
+    vector<int32_t> tasksLeft(n);
+    vector<uint64_t> counts(n);
+    uint64_t carryCount;
+    if (!read(&sampling, sizeof(sampling)) || !read(&base, sizeof(base)) ||
+        !read(p.data(), p.size() * sizeof(double)) ||
+        !read(&sum, sizeof(sum)) ||
+        !read(tasksLeft.data(), n * sizeof(int32_t)) ||
+        !read(counts.data(), n * sizeof(uint64_t)) ||
+        !read(&carryCount, sizeof(carryCount)) || carryCount > (uint64_t)n)
+        return false;
+    
+    map<int, uint64_t> carries;
+    for (uint64_t i = 0; i < carryCount; i++)
+    {
+        int32_t root;
+        uint64_t carry;
+        if (!read(&root, sizeof(root)) || !read(&carry, sizeof(carry)) ||
+            root < 0 || root >= n)
+            return false;
+        carries[root] = carry;
+    }
+    
+    // Class counts of a classifying run cannot be continued without them,
+    // nor made up for a run that did not classify
+    uint8_t classified;
+    uint64_t classCount;
+    if (!read(&classified, sizeof(classified)) ||
+        !read(&classCount, sizeof(classCount)) ||
+        (classified != 0) != classifying)
+        return false;
+    ClassCounts sums;
+    ClassVariance classSums;
+    for (uint64_t i = 0; i < classCount; i++)
+    {
+        uint64_t words[4];                  // key low, high, count low, high
+        double square;
+        if (!read(words, sizeof(words)) || !read(&square, sizeof(square)))
+            return false;
+        const ClassKey key = (ClassKey)words[1] << 64 | words[0];
+        sums[key] = Counter(words[2], words[3]);
+        if (square != 0.0)
+            classSums[key] = square;
+    }
+    
+    uint64_t taskCount;
+    if (!read(&taskCount, sizeof(taskCount)))
+        return false;
+    vector<ESUTask> tasks;
+    vector<uint64_t> seen(n, 0);
+    for (uint64_t i = 0; i < taskCount; i++)
+    {
+        int32_t fields[4];                  // root, branches, prefix, tail
+        if (!read(fields, sizeof(fields)) || fields[0] < 0 ||
+            fields[0] >= n || fields[1] < 0 || fields[2] < 0 ||
+            fields[2] > k - 2 || fields[3] < 0 || fields[3] > n ||
+            fields[1] > fields[3])
+            return false;
+        
+        ESUTask task;
+        task.root = fields[0];
+        task.branches = fields[1];
+        task.prefix.resize(fields[2]);
+        task.candidates.resize(fields[3]);
+        if (!read(task.prefix.data(), fields[2] * sizeof(int)) ||
+            !read(task.candidates.data(), fields[3] * sizeof(int)))
+            return false;
+        for (int v : task.prefix)
+            if (v <= task.root || v >= n)
+                return false;
+        for (int v : task.candidates)
+            if (v <= task.root || v >= n)
+                return false;
+        if (!publishable(task, seen, i + 1))
+            return false;
+        tasks.push_back(move(task));
+    }
+    
+    // Every outstanding task of a root is queued, and no other
+    vector<int32_t> queued(n, 0);
+    for (const ESUTask &task : tasks)
+        queued[task.root]++;
+    if (queued != tasksLeft)
+        return false;
+    
+    allocateRoots();
+    for (int v = 0; v < n; v++)
+    {
+        pending[v] = tasksLeft[v];
+        rootTotals[v] = counts[v];
+    }
+    rootCarries.swap(carries);
+    sampled = sampling != 0;
+    probabilities = sampled ? p : vector<double>();
+    seed = base;
+    savedSquares = sum;
+    savedClassSquares.swap(classSums);
+    savedClasses.swap(sums);
+    saved.swap(tasks);
+    resumed = true;
+    
+    return true;
+}
+
+//-------------------------------- classSnapshot -------------------------------
+// Subgraphs found so far by the run in progress by class, for progress
+// reports; the workers are not stopped
+// Preconditions: May be called from any thread during run
+// Postconditions: For k <= Classifier::CACHE_SIZE, returns the counts of the
+//                 tasks completed so far, each at most slightly behind; for
+//                 larger k, only those of a resumed checkpoint
+ClassCounts Census::classSnapshot() const
+{
+    return histogramClasses(true);
+}
+
+//--------------------------------- workerTotals -------------------------------
+// Number of subgraphs found by each worker in the last run
+// Preconditions: None
+// Postconditions: Returns one count per worker
+vector<Counter> Census::workerTotals() const
+{
+    vector<Counter> totals;
+    for (const Worker &worker : workers)
+        totals.push_back(worker.count);
+    
+    return totals;
+}
+
+
+//----------------------------------- estimate ---------------------------------
+// Estimated number of size-k subgraphs
+// Preconditions: None
+// Postconditions: Returns total() plus the predicted count of unfinished
+//                 roots, scaled by the inverse sampling probability;
+//                 equal to total() for a complete exact census
+double Census::estimate() const
+{
+    return (merged.value() + remainder) * weight();
+}
+
+//----------------------------------- variance ---------------------------------
+// Estimated variance of estimate()
+// Preconditions: None
+// Postconditions: Returns the Horvitz-Thompson variance of the sample
+//                 plus the prediction variance of unfinished roots; 0 for
+//                 a complete exact census
+double Census::variance() const
+{
+    const double sample = sampled ? squares : 0.0;
+    
+    return (sample + remainderVariance) * weight() * weight();
+}
+
+//-------------------------------- classVariance -------------------------------
+// Estimated variance of the estimated count of one class, its share of
+// estimate()
+// Preconditions: None
+// Postconditions: Returns the Horvitz-Thompson variance of the class's
+//                 sample plus its share of the prediction variance of
+//                 unfinished roots; 0 for a complete exact census or a class
+//                 that was not found
+double Census::classVariance(const ClassKey &key) const
+{
+    auto count = classes.find(key);
+    if (count == classes.end())
+        return 0.0;
+    
+    auto sum = classSquares.find(key);
+    const double sample = sampled && sum != classSquares.end() ?
+                          sum->second : 0.0;
+    const double share = count->second.value() / classified;
+    
+    return (sample + share * share * remainderVariance) * weight() * weight();
+}
+
+//----------------------------------- display ----------------------------------
+// Display the result of the last run
+// Preconditions: None
+// Postconditions: The count, or the estimate with its standard error and
+//                 95% confidence interval, is displayed, together with
+//                 the finished roots of an incomplete run and the
+//                 classes, if counted
+void Census::display() const
+{
+    const bool exact = !sampled && complete();
+    if (exact)
+        cout << "Subgraphs = " << merged << endl;
+    else
+    {
+        const double error = sqrt(variance());
+        if (!complete())
+            cout << "Budget exhausted: finished roots = " << finished
+                 << " of " << roots << endl;
+        cout << (sampled ? "Sampled subgraphs = " : "Counted subgraphs = ")
+             << merged << endl;
+        cout << "Estimated subgraphs = " << estimate()
+             << " (standard error " << error << ", 95% CI "
+             << estimate() - 1.96 * error << " .. "
+             << estimate() + 1.96 * error << ")" << endl;
+    }
+    
+    if (!classifying)
+        return;
+    
+    // One line per class, most frequent first: its graph6 label, the count
+    // of the subgraphs classified, the concentration and, when those are a
+    // sample, the estimated count with its standard error and interval
+    vector<pair<Counter, ClassKey>> order;
+    for (const pair<const ClassKey, Counter> &entry : classes)
+        order.push_back(make_pair(entry.second, entry.first));
+    sort(order.begin(), order.end(),
+         [](const pair<Counter, ClassKey> &a, const pair<Counter, ClassKey> &b)
+    {
+        if (a.first.value() != b.first.value())
+            return a.first.value() > b.first.value();
+        return a.second < b.second;
+    });
+    
+    // The labels are encoded in one batch, one line of equal length each
+    vector<ClassKey> keys;
+    for (const pair<Counter, ClassKey> &entry : order)
+        keys.push_back(entry.second);
+    string labels;
+    GraphCodec::encodeTriangles(keys.data(), keys.size(), k, labels);
+    const size_t length = labels.size() / max<size_t>(keys.size(), 1);
+    
+    cout << "Classes = " << order.size() << endl;
+    for (size_t c = 0; c < order.size(); c++)
+    {
+        const pair<Counter, ClassKey> &entry = order[c];
+        const double share = entry.first.value() / classified;
+        cout.write(labels.data() + c * length, length - 1);
+        cout << " " << entry.first << " " << 100.0 * share << "%";
+        if (!exact)
+        {
+            const double count = share * estimate();
+            const double error = sqrt(classVariance(entry.second));
+            cout << " ~" << count << " (standard error " << error
+                 << ", 95% CI " << count - 1.96 * error << " .. "
+                 << count + 1.96 * error << ")";
+        }
+        cout << endl;
+    }
+}
+
+
+//------------------------------- PRIVATE: weight ------------------------------
+// Inverse probability that the sample finds a given subgraph
+// Preconditions: None
+// Postconditions: Returns 1 for an exact census
+double Census::weight() const
+{
+    double found = 1.0;
+    if (sampled)
+        for (int size = 1; size <= k; size++)
+            found *= probabilities[size];
+    
+    return 1.0 / found;
+}
+
+
+//--------------------------- PRIVATE: checkpointLoop --------------------------
+// Body of the checkpoint thread: every checkpointSeconds, pause the workers
+// and write a checkpoint, until the run is over
+// Preconditions: run has started the workers
+// Postconditions: No worker is left paused
+void Census::checkpointLoop()
+{
+    const int T = (int)workers.size();
+    const chrono::duration<double> interval(checkpointSeconds);
+    
+    unique_lock<mutex> guard(clock);
+    while (!tick.wait_for(guard, interval, [this] { return finishedRun; }))
+    {
+        // Workers that have left the run hold nothing in flight either
+        pausing = true;
+        while (paused.load() + exited.load() < T)
+            this_thread::sleep_for(chrono::milliseconds(1));
+        writeCheckpoint();
+        pausing = false;
+    }
+}
+
+//--------------------------- PRIVATE: writeCheckpoint -------------------------
+// Write the progress of the run to checkpointFile
+// Preconditions: No worker has a task in flight
+// Postconditions: Returns false if the file could not be written; the
+//                 previous checkpoint is then left in place
+bool Census::writeCheckpoint()
+{
+    const string temporary = checkpointFile + ".tmp";
+    ofstream outfile(temporary.c_str(), ios::binary | ios::trunc);
+    if (!outfile)
+        return false;
+    
+    auto write = [&](const void *data, size_t bytes)
+    {
+        outfile.write(reinterpret_cast<const char *>(data),
+                      (streamsize)bytes);
+    };
+    
+    const int32_t size = k, n = graph.vertexCount();
+    const uint64_t hash = fingerprint();
+    write("NEMOCKP", 8);
+    write(&CHECKPOINT_VERSION, sizeof(CHECKPOINT_VERSION));
+    write(&size, sizeof(size));
+    write(&n, sizeof(n));
+    write(&hash, sizeof(hash));
+    
+    const uint8_t sampling = sampled;
+    vector<double> p(probabilities);
+    p.resize(k + 1, 1.0);
+    double sum = savedSquares;
+    for (const Worker &worker : workers)
+        sum += worker.squares;
+    write(&sampling, sizeof(sampling));
+    write(&seed, sizeof(seed));
+    write(p.data(), p.size() * sizeof(double));
+    write(&sum, sizeof(sum));
+    
+    vector<int32_t> tasksLeft(n);
+    vector<uint64_t> counts(n);
+    for (int v = 0; v < n; v++)
+    {
+        tasksLeft[v] = pending[v];
+        counts[v] = rootTotals[v];
+    }
+    write(tasksLeft.data(), n * sizeof(int32_t));
+    write(counts.data(), n * sizeof(uint64_t));
+    {
+        lock_guard<mutex> guard(carryLock);
+        const uint64_t carryCount = rootCarries.size();
+        write(&carryCount, sizeof(carryCount));
+        for (const pair<const int, uint64_t> &carry : rootCarries)
+        {
+            const int32_t root = carry.first;
+            write(&root, sizeof(root));
+            write(&carry.second, sizeof(carry.second));
+        }
+    }
+    
+    // Class counts as (key, count) pairs of two words each, each followed
+    // by the variance sum of the class
+    const ClassCounts sums = mergeClasses();
+    const ClassVariance classSums = mergeClassSquares();
+    const uint8_t classified = classifying;
+    const uint64_t classCount = sums.size();
+    write(&classified, sizeof(classified));
+    write(&classCount, sizeof(classCount));
+    for (const pair<const ClassKey, Counter> &entry : sums)
+    {
+        const uint64_t words[4] = {(uint64_t)entry.first,
+                                   (uint64_t)(entry.first >> 64),
+                                   entry.second.lowWord(),
+                                   entry.second.highWord()};
+        auto square = classSums.find(entry.first);
+        const double value = square == classSums.end() ? 0.0 : square->second;
+        write(words, sizeof(words));
+        write(&value, sizeof(value));
+    }
+    
+    uint64_t taskCount = 0;
+    for (const Worker &worker : workers)
+        taskCount += worker.tasks.size();
+    write(&taskCount, sizeof(taskCount));
+    for (const Worker &worker : workers)
+        for (const ESUTask &task : worker.tasks)
+        {
+            const int32_t fields[4] = {task.root, task.branches,
+                                       (int32_t)task.prefix.size(),
+                                       (int32_t)task.candidates.size()};
+            write(fields, sizeof(fields));
+            write(task.prefix.data(), task.prefix.size() * sizeof(int));
+            write(task.candidates.data(),
+                  task.candidates.size() * sizeof(int));
+        }
+    
+    if (!outfile.flush())
+        return false;
+    outfile.close();
+    
+    return rename(temporary.c_str(), checkpointFile.c_str()) == 0;
+}
+
+//---------------------------- PRIVATE: mergeClasses ---------------------------
+// Class counts of the run, from the checkpoint it resumed and every worker
+// Preconditions: No worker is running, or every one is paused
+// Postconditions: Returns the counts by class
+ClassCounts Census::mergeClasses() const
+{
+    ClassCounts counts = histogramClasses(false);
+    for (const Worker &worker : workers)
+        for (const pair<const ClassKey, Counter> &entry : worker.classes)
+            counts[entry.first] += entry.second;
+    
+    return counts;
+}
+
+//-------------------------- PRIVATE: mergeClassSquares ------------------------
+// Class variance sums of the run, from the checkpoint it resumed and every
+// worker
+// Preconditions: No worker is running, or every one is paused
+// Postconditions: Returns the sums by class
+ClassVariance Census::mergeClassSquares() const
+{
+    ClassVariance sums = savedClassSquares;
+    for (const Worker &worker : workers)
+        for (const pair<const ClassKey, double> &entry : worker.classSquares)
+            sums[entry.first] += entry.second;
+    
+    return sums;
+}
+
+//-------------------------- PRIVATE: histogramClasses -------------------------
+// Class counts of the checkpoint the run resumed and of every histogram
+// Preconditions: live, unless no worker is running or every one is paused
+// Postconditions: Returns the counts by class; live ones at most slightly
+//                 behind
+ClassCounts Census::histogramClasses(const bool &live) const
+{
+    lock_guard<mutex> guard(snapshotLock);
+    ClassCounts counts = savedClasses;
+    if (!classifying || k > Classifier::CACHE_SIZE)
+        return counts;
+    
+    // Add up the histograms slot by slot, then key the classes that occur
+    vector<Counter> sums(Classifier::classLimit(k));
+    for (const Worker &worker : workers)
+        if (live)
+            worker.histogram.addRecentTo(sums);
+        else
+            worker.histogram.addTo(sums);
+    for (int id = 0; id < (int)sums.size(); id++)
+        if (sums[id] != 0)
+            counts[Classifier::classKey(k, id)] += sums[id];
+    
+    return counts;
+}
+
+//----------------------------- PRIVATE: publishable ---------------------------
+// Check that a task read from a checkpoint is one an engine could have
+// published
+// Preconditions: Every vertex of task is above its root and below
+//                graph.vertexCount(); seen has an entry per vertex, none of
+//                them mark
+// Postconditions: Returns false unless the prefix and the candidates are
+//                 distinct vertices, each adjacent to the root or to a
+//                 member before it, and a subtree has a candidate. The
+//                 vertices of task are marked in seen.
+bool Census::publishable(const ESUTask &task, vector<uint64_t> &seen,
+                         const uint64_t &mark) const
+{
+    // Adjacency rows are sorted, and the edge index may not be built
+    auto reaches = [&](const int &v, const size_t &members)
+    {
+        if (binary_search(graph.neighborBegin(task.root),
+                          graph.neighborEnd(task.root), v))
+            return true;
+        for (size_t d = 0; d < members; d++)
+            if (binary_search(graph.neighborBegin(task.prefix[d]),
+                              graph.neighborEnd(task.prefix[d]), v))
+                return true;
+        return false;
+    };
+    
+    // An empty tail marks a whole root, which must not have a prefix
+    if (!task.prefix.empty() && task.candidates.empty())
+        return false;
+    
+    long reach = graph.degree(task.root);
+    for (size_t d = 0; d < task.prefix.size(); d++)
+    {
+        const int v = task.prefix[d];
+        if (seen[v] == mark || !reaches(v, d))
+            return false;
+        seen[v] = mark;
+        reach += graph.degree(v);
+    }
+    
+    // The engine copies the candidates into the extension slice of their
+    // depth, which holds every distinct neighbor of the members and no more
+    if ((long)task.candidates.size() > reach)
+        return false;
+    for (int v : task.candidates)
+    {
+        if (seen[v] == mark || !reaches(v, task.prefix.size()))
+            return false;
+        seen[v] = mark;
+    }
+    
+    return true;
+}
+
+//---------------------------- PRIVATE: fingerprint ----------------------------
+// Hash of the graph's adjacency, to tell whether a checkpoint belongs to it
+// Preconditions: None
+// Postconditions: A changed or renumbered graph almost surely hashes
+//                 differently
+uint64_t Census::fingerprint() const
+{
+    uint64_t hash = Random::mix(graph.vertexCount());
+    for (int v = 0; v < graph.vertexCount(); v++)
+        for (const int *p = graph.neighborBegin(v); p != graph.neighborEnd(v);
+             p++)
+            hash = Random::mix(hash ^ ((uint64_t)v << 32 | (uint32_t)*p));
+    
+    return hash;
+}
+
+//------------------------------- PRIVATE: credit ------------------------------
+// Add the count of a completed task to its root
+// Preconditions: None
+// Postconditions: rootCount(root) has grown by found
+void Census::credit(const int &root, const Counter &found)
+{
+    const uint64_t add = found.lowWord();
+    const uint64_t before = rootTotals[root].fetch_add(add);
+    const uint64_t carry = found.highWord() + (before + add < before);
+    if (carry != 0)
+    {
+        lock_guard<mutex> guard(carryLock);
+        rootCarries[root] += carry;
+    }
+}
+
+//----------------------------- PRIVATE: rootCount -----------------------------
+// Count of the completed tasks of root
+// Preconditions: No worker is running
+// Postconditions: Returns the exact count, carries included
+Counter Census::rootCount(const int &root) const
+{
+    auto carry = rootCarries.find(root);
+    
+    return Counter(rootTotals[root],
+                   carry == rootCarries.end() ? 0 : carry->second);
+}
+
+//------------------------------- PRIVATE: spend -------------------------------
+// Charge nodes tree nodes to the budget
+// Preconditions: None
+// Postconditions: Returns true, and stops every worker, once a limit is
+//                 reached
+bool Census::spend(const long &nodes)
+{
+    const long used = nodesUsed.fetch_add(nodes, memory_order_relaxed) + nodes;
+    if ((nodeLimit > 0 && used >= nodeLimit) ||
+        (secondsLimit > 0.0 && chrono::steady_clock::now() >= deadline))
+        stopped = true;
+    
+    return stopped.load();
+}
+
+//---------------------------- PRIVATE: allocateRoots --------------------------
+// Size pending and rootTotals for every vertex, reusing them from the last
+// run unless the graph has changed size
+// Preconditions: No worker is running
+// Postconditions: Both hold graph.vertexCount() entries, whose values are
+//                 left to the caller
+void Census::allocateRoots()
+{
+    const int n = graph.vertexCount();
+    if (n == rootSlots)
+        return;
+    pending.reset(new atomic<int>[n]);
+    rootTotals.reset(new atomic<uint64_t>[n]);
+    rootSlots = n;
+}
+
+//------------------------------ PRIVATE: stratify -----------------------------
+// Count the auxiliary of every root and split the roots into hubs and the
+// rest; with order, also order them for a budgeted run
+// Preconditions: order, if given, holds every root
+// Postconditions: auxiliary and certain describe every vertex
+void Census::stratify(vector<int> *order)
+{
+    // Size 2 (the higher neighbors) when size 3 is not much cheaper than k.
+    // A root without any auxiliary subgraph has no size-k subgraph either.
+    const int n = graph.vertexCount();
+    ESUEngine engine(graph, k > 3 ? 3 : 2);
+    auxiliary.assign(n, 0);
+    certain.assign(n, false);
+    double sum = 0.0;
+    int count = 0;
+    for (int v = 0; v < n; v++)
+        if (graph.degree(v) > 0)
+        {
+            auxiliary[v] = (long)engine.enumerateRoot(v).lowWord();
+            sum += auxiliary[v];
+            count++;
+        }
+    
+    const double cutoff = CERTAIN * sum / max(1, count);
+    vector<int> hubs, rest;
+    for (int v = 0; v < n; v++)
+        if (graph.degree(v) > 0)
+        {
+            certain[v] = auxiliary[v] > cutoff;
+            (certain[v] ? hubs : rest).push_back(v);
+        }
+    if (order == nullptr)
+        return;
+    
+    // Shuffle each stratum, then spread the hubs evenly among the others so
+    // that every prefix of the order samples both strata in proportion
+    Random random(Random::mix(seed));
+    for (vector<int> *stratum : {&hubs, &rest})
+        for (int i = (int)stratum->size() - 1; i > 0; i--)
+            swap((*stratum)[i], (*stratum)[random.below(i + 1)]);
+    
+    order->clear();
+    size_t h = 0, r = 0;
+    while (h < hubs.size() || r < rest.size())
+    {
+        // Take a hub whenever hubs are behind their share of the order
+        if (h < hubs.size() &&
+            (r == rest.size() || h * rest.size() <= r * hubs.size()))
+            order->push_back(hubs[h++]);
+        else
+            order->push_back(rest[r++]);
+    }
+}
+
+//------------------------------ PRIVATE: predict ------------------------------
+// Predict the count of the unfinished roots of one stratum from its
+// finished ones and add it to remainder and remainderVariance
+// Preconditions: The workers have joined and stratify has run
+// Postconditions: Nothing is added when every root of the stratum finished
+void Census::predict(const bool &hubs)
+{
+    const int n = graph.vertexCount();
+    double finishedX = 0.0, finishedY = 0.0, unfinishedX = 0.0;
+    long finishedMax = 0, unfinishedMax = 0;
+    int sampleSize = 0, unfinishedRoots = 0;
+    for (int v = 0; v < n; v++)
+    {
+        if (auxiliary[v] == 0 || certain[v] != hubs)
+            continue;
+        if (pending[v] == 0)
+        {
+            finishedX += auxiliary[v];
+            finishedY += rootCount(v).value();
+            finishedMax = max(finishedMax, auxiliary[v]);
+            sampleSize++;
+        }
+        else
+        {
+            unfinishedX += auxiliary[v];
+            unfinishedMax = max(unfinishedMax, auxiliary[v]);
+            unfinishedRoots++;
+        }
+    }
+    
+    if (unfinishedRoots == 0)
+        return;
+    
+    const double ratio = sampleSize > 0 ? finishedY / finishedX : 0.0;
+    remainder += ratio * unfinishedX;
+    
+    // ESU trees grow faster than the auxiliary, so a root far beyond every
+    // finished one says nothing the ratio can predict; nor do fewer than two
+    // finished roots tell how far off the prediction is
+    if (sampleSize < 2 || unfinishedMax > 2 * finishedMax)
+    {
+        remainderVariance = HUGE_VAL;
+        return;
+    }
+    
+    double residuals = 0.0;
+    for (int v = 0; v < n; v++)
+        if (auxiliary[v] > 0 && certain[v] == hubs && pending[v] == 0)
+        {
+            const double e = rootCount(v).value() - ratio * auxiliary[v];
+            residuals += e * e;
+        }
+    
+    // Variance of the ratio estimate of the stratum total over its N roots
+    // from a simple random sample of m of them
+    const double N = sampleSize + unfinishedRoots, m = sampleSize;
+    remainderVariance += N * N * (1.0 - m / N) / m * residuals / (m - 1);
+}
+
+//-------------------------------- PRIVATE: work -------------------------------
+// Body of worker id: drain its own deque, then steal, until every worker
+// is idle at the same time
+// Preconditions: The deques have been filled by run
+// Postconditions: workers[id].count holds what this worker found in the
+//                 tasks it completed
+void Census::work(const int &id)
+{
+    const int T = (int)workers.size();
+    if (!workers[id].engine)
+        workers[id].engine.reset(new ESUEngine(graph, k));
+    ESUEngine &engine = *workers[id].engine;
+    engine.reset();
+    auto publish = [this, id](ESUTask &&task)
+    {
+        pending[task.root]++;
+        lock_guard<mutex> guard(workers[id].lock);
+        workers[id].tasks.push_back(move(task));
+    };
+    if (sampled)
+        engine.enableSampling(probabilities, Random::mix(seed + id));
+    if (T > 1 && !sampled)
+        engine.enableSplitting(&idle, publish);
+    if (!checkpointFile.empty() && !sampled)
+        engine.enableSuspending(&pausing, publish);
+    if (classifying)
+        engine.enableClassification(workers[id].histogram);
+    if (secondsLimit > 0.0 || nodeLimit > 0)
+        engine.enableBudget([this](long nodes) { return spend(nodes); },
+                            sampled ? function<void(ESUTask &&)>() : publish);
+    
+    Counter count;
+    ESUTask task;
+    while (!stopped.load(memory_order_relaxed))
+    {
+        if (pausing.load(memory_order_relaxed))
+        {
+            workers[id].count = count;
+            pause(id, engine);
+            continue;
+        }
+        
+        if (nextTask(id, task))
+        {
+            const Counter found = engine.enumerateTask(task);
+            if (engine.aborted())
+            {
+                // A sampled task is only counted whole: keep all of it for a
+                // checkpoint of the stopped run. An exact one has published
+                // its remainder and is credited below like any other.
+                lock_guard<mutex> guard(workers[id].lock);
+                workers[id].tasks.push_back(move(task));
+            }
+            else
+            {
+                count += found;
+                credit(task.root, found);
+                pending[task.root]--;
+            }
+            continue;
+        }
+        
+        // Only a busy worker can publish, and it publishes into its own
+        // deque, which it drains before going idle. So once every worker is
+        // idle at the same time, no task exists or can appear.
+        idle++;
+        while (idle.load() < T && !anyTask() && !stopped.load() &&
+               !pausing.load())
+            this_thread::yield();
+        if (idle.load() == T || stopped.load())
+            break;
+        idle--;
+    }
+    
+    workers[id].count = count;
+    workers[id].squares = engine.varianceTerm();
+    workers[id].classSquares = engine.classVarianceTerms();
+    workers[id].classes = engine.classCounts();
+    exited++;
+}
+
+//-------------------------------- PRIVATE: pause ------------------------------
+// Hold worker id while a checkpoint is taken
+// Preconditions: The worker has no task in flight
+// Postconditions: Returns once the checkpoint is written
+void Census::pause(const int &id, const ESUEngine &engine)
+{
+    workers[id].squares = engine.varianceTerm();
+    workers[id].classSquares = engine.classVarianceTerms();
+    workers[id].classes = engine.classCounts();
+    paused++;
+    while (pausing.load())
+        this_thread::sleep_for(chrono::milliseconds(1));
+    paused--;
+}
+
+//------------------------------ PRIVATE: nextTask -----------------------------
+// Take the next task for worker id, from its own deque or by stealing
+// Preconditions: None
+// Postconditions: Returns false if every deque was seen empty
+bool Census::nextTask(const int &id, ESUTask &task)
+{
+    Worker &self = workers[id];
+    {
+        lock_guard<mutex> guard(self.lock);
+        if (!self.tasks.empty())
+        {
+            task = move(self.tasks.back());
+            self.tasks.pop_back();
+            return true;
+        }
+    }
+    
+    const int T = (int)workers.size();
+    for (int i = 1; i < T; i++)
+    {
+        Worker &victim = workers[(id + i) % T];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty())
+        {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+//------------------------------ PRIVATE: anyTask ------------------------------
+// Check whether some deque holds a task
+// Preconditions: None
+// Postconditions: Returns true if a task was seen
+bool Census::anyTask()
+{
+    for (Worker &worker : workers)
+    {
+        lock_guard<mutex> guard(worker.lock);
+        if (!worker.tasks.empty())
+            return true;
+    }
+    
+    return false;
+}
@@ -0,0 +1,436 @@
+//------------------------------------------------------------------------------
+//  Census.h
+//------------------------------------------------------------------------------
+// Census counts the connected size-k subgraphs of a Graph on one or more
+// threads. ESU trees of different roots are independent, so every root is a
+// task. Each worker owns an ESUEngine, a deque of ESUTasks and its own
+// counters; it pops tasks from the back of its own deque and, once that is
+// empty, steals from the front of the other workers' deques. While some
+// worker is idle, busy engines split subtrees off their stacks into their
+// own deques, so a hub root is shared out instead of finishing last. The
+// per-worker counters are merged when every worker has finished.
+//
+// A sampled census runs RAND-ESU and scales the sampled count by the inverse
+// of the probability p[1] * ... * p[k] of finding any one subgraph. Its
+// variance is the Horvitz-Thompson estimate the engines accumulate over the
+// sampled ESU trees (see ESUEngine.h). That sum needs whole ESU trees, so a
+// sampled census never splits subtrees off a root. A classifying census
+// keeps the sum for every class as well, for the variance of each class's
+// estimated count.
+//
+// A census can run under a budget of wall-clock seconds and/or ESU tree
+// nodes. When the budget runs out every worker stops its task, leaving the
+// unexpanded rest of it queued (a sampled task is queued whole), and the
+// census keeps the exact count of the roots whose whole ESU tree finished
+// (a root split into subtrees finishes when all of its subtrees do). Under a
+// budget every root first gets an auxiliary count that is cheap to find, the
+// number of connected 3-vertex subgraphs it roots. Roots whose auxiliary
+// count is more than CERTAIN times the mean form a stratum of hubs, since
+// their ESU trees grow much faster than the auxiliary. Both strata are dealt
+// in random order, the hubs spread evenly among the other roots, so the
+// finished roots are close to a stratified random sample. Within each
+// stratum the count of the unfinished roots is predicted with a ratio
+// estimator against the auxiliary count, with the ratio-estimator variance
+// of a simple random sample. The variance is infinite when a stratum has
+// fewer than two finished roots, or an unfinished root with more than twice
+// the auxiliary of any finished one: ESU trees grow faster than the
+// auxiliary, so no ratio predicts such a root.
+//
+// A census can also classify every subgraph it finds (see Classifier) and
+// report the count and concentration of each isomorphism class. Class
+// counts come from completed tasks, so after an incomplete run they are
+// those of a subset of the tree and are reported as concentrations scaled
+// to the estimated total. The variance of such a scaled count is that of
+// its sampled count plus its share of the prediction variance of the
+// unfinished roots, taking the concentration as fixed.
+// For k <= Classifier::CACHE_SIZE every worker counts classes in a
+// Histogram of its own, by dense class ID, so that no two workers ever write
+// the same cache line. The histograms are added up when the run ends or a
+// checkpoint is written, and classSnapshot adds them up mid-run, for
+// progress reports, without stopping the workers.
+//
+// A census can save its progress to a checkpoint file every so many
+// seconds. To write one, every worker is paused with nothing in flight: an
+// exact engine suspends its task into subtree tasks, while a sampled one
+// finishes its task first. The file then holds the per-root counts and
+// outstanding-task counters, the variance sums so far and every queued task,
+// and a new Census on the same graph can resume from it. A run that
+// completes removes its checkpoint; a run stopped by its budget writes a
+// final one, so it can be continued later.
+//
+// ASSUMPTIONS:
+//   -- The Graph is not modified while a census runs on it
+//   -- 2 <= k
+//
+//------------------------------------------------------------------------------
+
+#ifndef __Census__
+#define __Census__
+
+#include "Classifier.h"
+#include "Counter.h"
+#include "Graph.h"
+#include "ESUEngine.h"
+#include "Histogram.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class Census
+{
+public:
+    
+    //------------------------------- Constructor ------------------------------
+    // Prepare a census of the size-k subgraphs of graph on threads workers
+    // Preconditions: 2 <= k
+    // Postconditions: Nothing is counted until run is called. A threads value
+    //                 below 1 means one worker.
+    Census(const Graph &graph, const int &k, const int &threads = 1);
+    
+    //------------------------------- Destructor -------------------------------
+    // Destructor for class Census
+    // Preconditions: None
+    // Postconditions: None
+    ~Census();
+    
+    
+    //----------------------------------- run ----------------------------------
+    // Enumerate every size-k subgraph of the graph
+    // Preconditions: None
+    // Postconditions: total() and workerTotals() hold the counts of this run
+    void run();
+    
+    //------------------------------- setSampling ------------------------------
+    // Make the next runs RAND-ESU samples with the per-size probabilities
+    // p[1 .. k]
+    // Preconditions: p.size() == k + 1 and every p[s] is in (0, 1]; p[0] is
+    //                ignored
+    // Postconditions: Runs draw from generators derived from seed
+    void setSampling(const vector<double> &p, const uint64_t &seed = 1);
+    
+    //-------------------------------- setBudget -------------------------------
+    // Limit the next runs to seconds of wall-clock time and to nodes ESU tree
+    // nodes over all workers
+    // Preconditions: None
+    // Postconditions: A limit of 0 is no limit; when both are 0 runs always
+    //                 complete
+    void setBudget(const double &seconds, const long &nodes = 0);
+    
+    //---------------------------- setClassification ---------------------------
+    // Make the next runs count subgraphs by isomorphism class too
+    // Preconditions: k <= Classifier::MAX_SIZE
+    // Postconditions: classCounts() holds the class counts of each run
+    void setClassification();
+    
+    //------------------------------ setCheckpoint -----------------------------
+    // Save the progress of the next runs to filename every seconds seconds
+    // Preconditions: seconds > 0
+    // Postconditions: The file is replaced atomically at each checkpoint
+    void setCheckpoint(const string &filename, const double &seconds);
+    
+    //--------------------------------- resume ---------------------------------
+    // Continue the next run from a checkpoint instead of from scratch
+    // Preconditions: setClassification, if wanted, has been called
+    // Postconditions: Returns false, leaving the census unchanged, if
+    //                 filename could not be read, is inconsistent, or was
+    //                 written for another graph, k or classification
+    //                 setting. Otherwise the sampling settings are those of
+    //                 the checkpointed run.
+    bool resume(const string &filename);
+    
+    //-------------------------------- complete --------------------------------
+    // Whether the last run finished every root
+    // Preconditions: None
+    // Postconditions: Returns false if the budget ran out first
+    bool complete() const { return finished == roots; }
+    
+    //------------------------------ finishedRoots -----------------------------
+    // Roots whose whole ESU tree was enumerated in the last run
+    // Preconditions: None
+    // Postconditions: Returns a number between 0 and rootCount()
+    int finishedRoots() const { return finished; }
+    
+    //-------------------------------- rootCount -------------------------------
+    // Roots of the last run, i.e. vertices with at least one neighbor
+    // Preconditions: None
+    // Postconditions: Returns the number of root tasks that were dealt
+    int rootCount() const { return roots; }
+    
+    //---------------------------------- total ---------------------------------
+    // Number of subgraphs found by the last run in the roots it finished
+    // Preconditions: None
+    // Postconditions: Returns the exact count of every finished root; with
+    //                 sampling, the number of sampled subgraphs
+    Counter total() const { return merged; }
+    
+    //------------------------------- classCounts ------------------------------
+    // Subgraphs found by the last run by class (see Classifier)
+    // Preconditions: None
+    // Postconditions: Empty unless classification is set
+    const ClassCounts &classCounts() const { return classes; }
+    
+    //------------------------------ classSnapshot -----------------------------
+    // Subgraphs found so far by the run in progress by class, for progress
+    // reports; the workers are not stopped
+    // Preconditions: May be called from any thread during run
+    // Postconditions: For k <= Classifier::CACHE_SIZE, returns the counts of
+    //                 the tasks completed so far, each at most slightly
+    //                 behind; for larger k, only those of a resumed
+    //                 checkpoint
+    ClassCounts classSnapshot() const;
+    
+    //------------------------------ workerTotals ------------------------------
+    // Number of subgraphs found by each worker in the last run
+    // Preconditions: None
+    // Postconditions: Returns one count per worker
+    vector<Counter> workerTotals() const;
+    
+    //-------------------------------- estimate --------------------------------
+    // Estimated number of size-k subgraphs
+    // Preconditions: None
+    // Postconditions: Returns total() plus the predicted count of unfinished
+    //                 roots, scaled by the inverse sampling probability;
+    //                 equal to total() for a complete exact census
+    double estimate() const;
+    
+    //-------------------------------- variance --------------------------------
+    // Estimated variance of estimate()
+    // Preconditions: None
+    // Postconditions: Returns the Horvitz-Thompson variance of the sample
+    //                 plus the prediction variance of unfinished roots; 0 for
+    //                 a complete exact census
+    double variance() const;
+    
+    //------------------------------ classVariance -----------------------------
+    // Estimated variance of the estimated count of one class, its share of
+    // estimate()
+    // Preconditions: None
+    // Postconditions: Returns the Horvitz-Thompson variance of the class's
+    //                 sample plus its share of the prediction variance of
+    //                 unfinished roots; 0 for a complete exact census or a
+    //                 class that was not found
+    double classVariance(const ClassKey &key) const;
+    
+    //--------------------------------- display --------------------------------
+    // Display the result of the last run
+    // Preconditions: None
+    // Postconditions: The count, or the estimate with its standard error and
+    //                 95% confidence interval, is displayed, together with
+    //                 the finished roots of an incomplete run and the
+    //                 classes, if counted, each with its estimate, standard
+    //                 error and interval unless the census is exact
+    void display() const;
+    
+    
+private:
+    
+    // State owned by one worker. Aligned to a cache line so that workers
+    // updating their counters never share a line.
+    struct alignas(64) Worker
+    {
+        mutex lock;                         // guards tasks
+        deque<ESUTask> tasks;               // roots and subtrees to expand
+        Counter count;                      // subgraphs found by this worker
+        double squares = 0.0;               // engine's varianceTerm
+        ClassVariance classSquares;         // engine's classVarianceTerms
+        ClassCounts classes;                // engine's classCounts
+        Histogram histogram;                // classes by dense class ID
+        unique_ptr<ESUEngine> engine;       // kept from run to run
+    };
+    
+    const Graph &graph;                     // graph being enumerated
+    const int k;                            // subgraph size
+    vector<Worker> workers;                 // one per thread
+    atomic<int> idle;                       // workers waiting for tasks
+    Counter merged;                         // sum of the finished roots
+    double squares = 0.0;                   // merged varianceTerm
+    bool classifying = false;               // count classes too
+    ClassCounts classes;                    // merged classCounts
+    double classified = 0.0;                // subgraphs in classes
+    ClassVariance classSquares;             // merged classVarianceTerms
+    
+    bool sampled = false;                   // run RAND-ESU
+    vector<double> probabilities;           // p[1 .. k] of RAND-ESU
+    uint64_t seed = 1;                      // base seed of the generators
+    
+    double secondsLimit = 0.0;              // wall-clock budget, 0 for none
+    long nodeLimit = 0;                     // tree node budget, 0 for none
+    chrono::steady_clock::time_point deadline;
+    atomic<long> nodesUsed;                 // tree nodes over all workers
+    atomic<bool> stopped;                   // the budget ran out
+    
+    // Per-root bookkeeping: outstanding tasks (0 once the root is finished)
+    // and the count of its completed tasks, whose rare carries out of 64
+    // bits are kept aside
+    unique_ptr<atomic<int>[]> pending;
+    unique_ptr<atomic<uint64_t>[]> rootTotals;
+    int rootSlots = 0;                      // vertices the two are sized for
+    map<int, uint64_t> rootCarries;
+    mutex carryLock;                        // guards rootCarries
+    int roots = 0;                          // roots dealt in the last run
+    int finished = 0;                       // roots finished in the last run
+    vector<long> auxiliary;                 // 3-vertex subgraphs per root
+    vector<bool> certain;                   // root is in the hub stratum
+    double remainder = 0.0;                 // predicted unfinished count
+    double remainderVariance = 0.0;         // variance of remainder
+    
+    static const int CERTAIN = 8;           // hub stratum cut-off, see above
+    
+    string checkpointFile;                  // where progress is saved
+    double checkpointSeconds = 0.0;         // time between checkpoints
+    atomic<bool> pausing;                   // a checkpoint is being taken
+    atomic<int> paused;                     // workers waiting for it
+    atomic<int> exited;                     // workers that have finished
+    mutex clock;                            // guards finishedRun
+    condition_variable tick;                // wakes the checkpoint thread
+    bool finishedRun = false;               // the workers have joined
+    bool resumed = false;                   // next run starts from a file
+    vector<ESUTask> saved;                  // queued tasks of the checkpoint
+    double savedSquares = 0.0;              // variance sum of the checkpoint
+    ClassCounts savedClasses;               // class counts of the checkpoint
+    ClassVariance savedClassSquares;        // class sums of the checkpoint
+    mutable mutex snapshotLock;             // run is setting up class counts
+    
+    static const uint32_t CHECKPOINT_VERSION = 4;
+    
+    
+    //----------------------------- PRIVATE: work ------------------------------
+    // Body of worker id: drain its own deque, then steal, until every worker
+    // is idle at the same time
+    // Preconditions: The deques have been filled by run
+    // Postconditions: workers[id].count holds what this worker found
+    void work(const int &id);
+    
+    //---------------------------- PRIVATE: nextTask ---------------------------
+    // Take the next task for worker id, from its own deque or by stealing
+    // Preconditions: None
+    // Postconditions: Returns false if every deque was seen empty
+    bool nextTask(const int &id, ESUTask &task);
+    
+    //---------------------------- PRIVATE: anyTask ----------------------------
+    // Check whether some deque holds a task
+    // Preconditions: None
+    // Postconditions: Returns true if a task was seen
+    bool anyTask();
+    
+    //------------------------- PRIVATE: checkpointLoop -----------------------
+    // Body of the checkpoint thread: every checkpointSeconds, pause the
+    // workers and write a checkpoint, until the run is over
+    // Preconditions: run has started the workers
+    // Postconditions: No worker is left paused
+    void checkpointLoop();
+    
+    //---------------------------- PRIVATE: pause ------------------------------
+    // Hold worker id while a checkpoint is taken
+    // Preconditions: The worker has no task in flight
+    // Postconditions: Returns once the checkpoint is written
+    void pause(const int &id, const ESUEngine &engine);
+    
+    //----------------------- PRIVATE: writeCheckpoint -------------------------
+    // Write the progress of the run to checkpointFile
+    // Preconditions: No worker has a task in flight
+    // Postconditions: Returns false if the file could not be written; the
+    //                 previous checkpoint is then left in place
+    bool writeCheckpoint();
+    
+    //-------------------------- PRIVATE: mergeClasses ------------------------
+    // Class counts of the run, from the checkpoint it resumed and every
+    // worker
+    // Preconditions: No worker is running, or every one is paused
+    // Postconditions: Returns the counts by class
+    ClassCounts mergeClasses() const;
+    
+    //------------------------ PRIVATE: mergeClassSquares ----------------------
+    // Class variance sums of the run, from the checkpoint it resumed and
+    // every worker
+    // Preconditions: No worker is running, or every one is paused
+    // Postconditions: Returns the sums by class
+    ClassVariance mergeClassSquares() const;
+    
+    //------------------------ PRIVATE: histogramClasses -----------------------
+    // Class counts of the checkpoint the run resumed and of every histogram
+    // Preconditions: live, unless no worker is running or every one is
+    //                paused
+    // Postconditions: Returns the counts by class; live ones at most
+    //                 slightly behind
+    ClassCounts histogramClasses(const bool &live) const;
+    
+    //-------------------------- PRIVATE: publishable --------------------------
+    // Check that a task read from a checkpoint is one an engine could have
+    // published
+    // Preconditions: Every vertex of task is above its root and below
+    //                graph.vertexCount(); seen has an entry per vertex, none
+    //                of them mark
+    // Postconditions: Returns false unless the prefix and the candidates are
+    //                 distinct vertices, each adjacent to the root or to a
+    //                 member before it, and a subtree has a candidate. The
+    //                 vertices of task are marked in seen.
+    bool publishable(const ESUTask &task, vector<uint64_t> &seen,
+                     const uint64_t &mark) const;
+    
+    //--------------------------- PRIVATE: fingerprint -------------------------
+    // Hash of the graph's adjacency, to tell whether a checkpoint belongs
+    // to it
+    // Preconditions: None
+    // Postconditions: A changed or renumbered graph almost surely hashes
+    //                 differently
+    uint64_t fingerprint() const;
+    
+    //---------------------------- PRIVATE: credit -----------------------------
+    // Add the count of a completed task to its root
+    // Preconditions: None
+    // Postconditions: rootCount(root) has grown by found
+    void credit(const int &root, const Counter &found);
+    
+    //--------------------------- PRIVATE: rootCount ---------------------------
+    // Count of the completed tasks of root
+    // Preconditions: No worker is running
+    // Postconditions: Returns the exact count, carries included
+    Counter rootCount(const int &root) const;
+    
+    //---------------------------- PRIVATE: spend ------------------------------
+    // Charge nodes tree nodes to the budget
+    // Preconditions: None
+    // Postconditions: Returns true, and stops every worker, once a limit is
+    //                 reached
+    bool spend(const long &nodes);
+    
+    //------------------------- PRIVATE: allocateRoots -------------------------
+    // Size pending and rootTotals for every vertex, reusing them from the
+    // last run unless the graph has changed size
+    // Preconditions: No worker is running
+    // Postconditions: Both hold graph.vertexCount() entries, whose values
+    //                 are left to the caller
+    void allocateRoots();
+    
+    //---------------------------- PRIVATE: stratify ---------------------------
+    // Count the auxiliary of every root and split the roots into hubs and
+    // the rest; with order, also order them for a budgeted run
+    // Preconditions: order, if given, holds every root
+    // Postconditions: auxiliary and certain describe every vertex
+    void stratify(vector<int> *order);
+    
+    //--------------------------- PRIVATE: predict -----------------------------
+    // Predict the count of the unfinished roots of one stratum from its
+    // finished ones and add it to remainder and remainderVariance
+    // Preconditions: The workers have joined and stratify has run
+    // Postconditions: Nothing is added when every root of the stratum
+    //                 finished
+    void predict(const bool &hubs);
+    
+    //---------------------------- PRIVATE: weight -----------------------------
+    // Inverse probability that the sample finds a given subgraph
+    // Preconditions: None
+    // Postconditions: Returns 1 for an exact census
+    double weight() const;
+};
+
+#endif /* defined(__Census__) */
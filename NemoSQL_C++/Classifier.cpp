@@ -0,0 +1,420 @@
+//------------------------------------------------------------------------------
+//  Classifier.cpp
+//------------------------------------------------------------------------------
+// Classifier finds the isomorphism class of a small graph with nauty's
+// densenauty, linked in-process from nautyL1.a. The graph is copied into
+// nauty's bit order, labeled canonically, and the canonical upper triangle
+// is packed into a ClassKey. The lookup tables for small k are built the
+// same way, once per k, and shared by every Classifier, as are the form
+// caches for larger k and the dense class IDs of both.
+//
+// A cache slot is 0 while empty, and otherwise holds (mask + 1) << 32 | id.
+// A slot is claimed with a single compare-and-swap and never changes
+// afterwards, so readers need no lock; two threads missing on the same form
+// both run nauty and get the same ID, and the loser of the race reads the
+// winner's equal entry. An ID is registered, under a lock, before any slot
+// holds it, and the key of each ID is stored in room reserved up front, so
+// classKey needs no lock either. The cache file holds canonical masks
+// instead of IDs, since IDs differ from run to run, and every one of them
+// is checked with nauty before any is loaded.
+//
+// ASSUMPTIONS:
+//   -- nauty is built with WORDSIZE=64 and MAXN=WORDSIZE (nautyL1.a), and
+//      also with -DUSE_TLS (nautyTL1.a) exactly when this file is
+//   -- 2 <= k <= MAX_SIZE
+//
+//------------------------------------------------------------------------------
+
+#ifndef WORDSIZE
+#define WORDSIZE 64
+#endif
+#ifndef MAXN
+#define MAXN WORDSIZE
+#endif
+
+#include "Classifier.h"
+#include "GraphCodec.h"
+#include "nauty.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+static_assert(sizeof(setword) == sizeof(uint64_t),
+              "nauty must be built with WORDSIZE=64");
+
+const int Classifier::MAX_SIZE;
+const int Classifier::TABLE_SIZE;
+const int Classifier::CACHE_SIZE;
+
+#ifndef USE_TLS
+// nautyL1.a keeps its work areas in static storage
+static mutex nautyLock;
+#endif
+
+// Graphs on k vertices up to isomorphism, k = 0 .. CACHE_SIZE (OEIS A000088)
+static const int GRAPH_COUNTS[Classifier::CACHE_SIZE + 1] =
+    {1, 1, 2, 4, 11, 34, 156, 1044, 12346};
+
+// Dense class IDs by k: the key of every ID handed out, and the reverse
+static mutex registryLock;
+static vector<ClassKey> classKeys[Classifier::CACHE_SIZE + 1];
+static unordered_map<ClassKey, int, ClassKeyHash>
+    classIds[Classifier::CACHE_SIZE + 1];
+
+// Lookup tables by k, each built by the first Classifier that needs it
+static once_flag tableOnce[Classifier::TABLE_SIZE + 1];
+static vector<uint16_t> tableIds[Classifier::TABLE_SIZE + 1];
+
+// Form caches by k, allocated by the first user of each
+static const size_t CACHE_SLOTS = (size_t)1 << 22;   // 32 MB per k
+static const int CACHE_PROBES = 16;     // slots tried before giving up
+static const uint32_t CACHE_VERSION = 1;
+static once_flag cacheOnce[Classifier::CACHE_SIZE + 1];
+static unique_ptr<atomic<uint64_t>[]> caches[Classifier::CACHE_SIZE + 1];
+
+//-------------------------------- registerClass -------------------------------
+// Dense class ID of the class with key among graphs on k vertices
+// Preconditions: k <= CACHE_SIZE; key is a canonical mask
+// Postconditions: Returns the ID of key, handing out the next one if key is
+//                 new; classKeys[k][id] == key
+static int registerClass(const int &k, const ClassKey &key)
+{
+    lock_guard<mutex> guard(registryLock);
+    auto found = classIds[k].find(key);
+    if (found != classIds[k].end())
+        return found->second;
+    
+    // Never reallocated, so that classKey can read while IDs are added
+    if (classKeys[k].capacity() == 0)
+        classKeys[k].reserve(GRAPH_COUNTS[k]);
+    const int id = (int)classKeys[k].size();
+    classKeys[k].push_back(key);
+    classIds[k][key] = id;
+    
+    return id;
+}
+
+//---------------------------------- formCache ---------------------------------
+// The form cache for k, allocated and emptied on first use
+// Preconditions: TABLE_SIZE < k <= CACHE_SIZE
+// Postconditions: Returns CACHE_SLOTS slots shared by every caller for k
+static atomic<uint64_t> *formCache(const int &k)
+{
+    call_once(cacheOnce[k], [k]
+    {
+        caches[k].reset(new atomic<uint64_t>[CACHE_SLOTS]());
+    });
+    
+    return caches[k].get();
+}
+
+//-------------------------------- insertForm ----------------------------------
+// Record that the graph with packed triangle mask has class ID id
+// Preconditions: cache was returned by formCache; id is registered
+// Postconditions: Returns false if the probe sequence of mask is full
+static bool insertForm(atomic<uint64_t> *cache, const uint32_t &mask,
+                       const uint32_t &id)
+{
+    const uint64_t tag = (uint64_t)(mask + 1) << 32;
+    size_t slot = Random::mix(mask) & (CACHE_SLOTS - 1);
+    for (int probe = 0; probe < CACHE_PROBES; probe++)
+    {
+        uint64_t entry = 0;
+        if (cache[slot].compare_exchange_strong(entry, tag | id,
+                                                memory_order_release,
+                                                memory_order_acquire) ||
+            (entry & ~(uint64_t)UINT32_MAX) == tag)
+            return true;
+        slot = (slot + 1) & (CACHE_SLOTS - 1);
+    }
+    
+    return false;
+}
+
+//--------------------------------- Constructor --------------------------------
+// Prepare to classify graphs of k vertices
+// Preconditions: 2 <= k <= MAX_SIZE
+// Postconditions: nauty has been checked against the headers it was
+//                 compiled with
+Classifier::Classifier(const int &k)
+    : k(k), adjacency(k), canonical(k), lab(k), ptn(k), orbits(k)
+{
+    nauty_check(WORDSIZE, 1, k, NAUTYVERSIONID);
+    
+    if (k <= TABLE_SIZE)
+    {
+        call_once(tableOnce[k], [this]
+        {
+            tabulate(tableIds[this->k]);
+        });
+        table = tableIds[k].data();
+    }
+    else if (k <= CACHE_SIZE)
+        cache = formCache(k);
+}
+
+//---------------------------------- Destructor --------------------------------
+// Destructor for class Classifier
+// Preconditions: None
+// Postconditions: None
+Classifier::~Classifier()
+{}
+
+
+//----------------------------------- classify ---------------------------------
+// Isomorphism class of the graph with adjacency rows[0 .. k-1]
+// Preconditions: Bit j of rows[i] is set when i and j are adjacent
+// Postconditions: Returns the ClassKey of its canonical labeling
+ClassKey Classifier::classify(const uint64_t *rows)
+{
+    if (k <= CACHE_SIZE)
+    {
+        uint32_t mask = 0;
+        int t = 0;
+        for (int j = 1; j < k; j++)
+            for (int i = 0; i < j; i++, t++)
+                mask |= (uint32_t)(rows[j] >> i & 1) << t;
+        return classKeys[k][classOf(mask)];
+    }
+    
+    // nauty numbers the bits of a set from the most significant one
+    for (int i = 0; i < k; i++)
+    {
+        uint64_t row = 0;
+        for (uint64_t bits = rows[i]; bits != 0; bits &= bits - 1)
+            row |= (uint64_t)1 << (WORDSIZE - 1 - __builtin_ctzll(bits));
+        adjacency[i] = row;
+    }
+    
+    return canonicalKey();
+}
+
+//---------------------------------- classKey ----------------------------------
+// ClassKey of a dense class ID of graphs on k vertices
+// Preconditions: id was returned by classOf of a Classifier for k
+// Postconditions: Returns the key classify gives the class
+ClassKey Classifier::classKey(const int &k, const int &id)
+{
+    return classKeys[k][id];
+}
+
+//--------------------------------- classLimit ---------------------------------
+// Bound on the dense class IDs for k, the number of graphs on k vertices up
+// to isomorphism
+// Preconditions: k <= CACHE_SIZE
+// Postconditions: Every ID classOf returns for k is below the result
+int Classifier::classLimit(const int &k)
+{
+    return GRAPH_COUNTS[k];
+}
+
+//------------------------------------ graph6 ----------------------------------
+// graph6 string of the canonical graph of a class of k-vertex graphs
+// Preconditions: key was returned by a Classifier for k
+// Postconditions: Returns the label labelg gives the class
+string Classifier::graph6(const ClassKey &key, const int &k)
+{
+    string label;
+    GraphCodec::encodeTriangles(&key, 1, k, label);
+    label.pop_back();
+    
+    return label;
+}
+
+//---------------------------------- loadCache ---------------------------------
+// Fill the canonical form cache for k from a file saved by saveCache
+// Preconditions: TABLE_SIZE < k <= CACHE_SIZE; no Classifier for k is
+//                classifying concurrently
+// Postconditions: Returns false, leaving the cache and the class IDs as they
+//                 were, if filename is missing, is not a cache for k, pairs
+//                 a mask with a key that is not its canonical form, or
+//                 would register more classes than there are
+bool Classifier::loadCache(const string &filename, const int &k)
+{
+    ifstream infile(filename.c_str(), ios::binary);
+    if (!infile)
+        return false;
+    
+    auto read = [&](void *data, size_t bytes)
+    {
+        return (bool)infile.read(reinterpret_cast<char *>(data),
+                                 (streamsize)bytes);
+    };
+    
+    char magic[8];
+    uint32_t version;
+    int32_t size;
+    uint64_t count;
+    if (!read(magic, 8) || memcmp(magic, "NEMOCLS", 8) != 0 ||
+        !read(&version, sizeof(version)) || version != CACHE_VERSION ||
+        !read(&size, sizeof(size)) || size != k ||
+        !read(&count, sizeof(count)) || count > CACHE_SLOTS)
+        return false;
+    
+    const uint64_t limit = (uint64_t)1 << (k * (k - 1) / 2);
+    vector<uint64_t> entries(count);
+    if (!read(entries.data(), count * sizeof(uint64_t)))
+        return false;
+    
+    // Check every entry before using any: a mask must label canonically to
+    // its key with nauty, exactly as lookUp would have found it
+    Classifier checker(k);
+    vector<ClassKey> keys;
+    for (const uint64_t &entry : entries)
+    {
+        const uint64_t mask = (entry >> 32) - 1, key = (uint32_t)entry;
+        if (mask >= limit)
+            return false;
+        checker.unpackMask((uint32_t)mask);
+        if (checker.canonicalKey() != key)
+            return false;
+        keys.push_back(key);
+    }
+    
+    // The IDs must fit in the room reserved for them, which classKey reads
+    // without a lock and the histograms are sized by
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+    {
+        lock_guard<mutex> guard(registryLock);
+        size_t fresh = 0;
+        for (const ClassKey &key : keys)
+            fresh += classIds[k].find(key) == classIds[k].end();
+        if (classKeys[k].size() + fresh > (size_t)GRAPH_COUNTS[k])
+            return false;
+    }
+    
+    atomic<uint64_t> *cache = formCache(k);
+    for (const uint64_t &entry : entries)
+        insertForm(cache, (uint32_t)((entry >> 32) - 1),
+                   registerClass(k, (uint32_t)entry));
+    
+    return true;
+}
+
+//---------------------------------- saveCache ---------------------------------
+// Write the canonical form cache for k to a file
+// Preconditions: TABLE_SIZE < k <= CACHE_SIZE; no Classifier for k is
+//                classifying concurrently
+// Postconditions: Returns false if filename could not be written
+bool Classifier::saveCache(const string &filename, const int &k)
+{
+    const string temporary = filename + ".tmp";
+    ofstream outfile(temporary.c_str(), ios::binary | ios::trunc);
+    if (!outfile)
+        return false;
+    
+    atomic<uint64_t> *cache = formCache(k);
+    vector<uint64_t> entries;
+    for (size_t slot = 0; slot < CACHE_SLOTS; slot++)
+    {
+        const uint64_t entry = cache[slot].load(memory_order_acquire);
+        if (entry != 0)
+            entries.push_back((entry & ~(uint64_t)UINT32_MAX) |
+                              (uint32_t)classKeys[k][(uint32_t)entry]);
+    }
+    
+    const int32_t size = k;
+    const uint64_t count = entries.size();
+    outfile.write("NEMOCLS", 8);
+    outfile.write(reinterpret_cast<const char *>(&CACHE_VERSION),
+                  sizeof(CACHE_VERSION));
+    outfile.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    outfile.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    outfile.write(reinterpret_cast<const char *>(entries.data()),
+                  (streamsize)(count * sizeof(uint64_t)));
+    
+    if (!outfile.flush())
+        return false;
+    outfile.close();
+    
+    return rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+
+//---------------------------- PRIVATE: canonicalKey ---------------------------
+// Label the graph in adjacency canonically with nauty
+// Preconditions: adjacency holds the graph in nauty's bit order
+// Postconditions: Returns the ClassKey of the canonical graph
+ClassKey Classifier::canonicalKey()
+{
+    DEFAULTOPTIONS_GRAPH(options);
+    options.getcanon = TRUE;
+    statsblk stats;
+    {
+#ifndef USE_TLS
+        lock_guard<mutex> guard(nautyLock);
+#endif
+        densenauty(reinterpret_cast<graph *>(adjacency.data()), lab.data(),
+                   ptn.data(), orbits.data(), &options, &stats, 1, k,
+                   reinterpret_cast<graph *>(canonical.data()));
+    }
+    
+    ClassKey key = 0;
+    int t = 0;
+    for (int j = 1; j < k; j++)
+        for (int i = 0; i < j; i++, t++)
+            if (canonical[i] >> (WORDSIZE - 1 - j) & 1)
+                key |= (ClassKey)1 << t;
+    
+    return key;
+}
+
+//------------------------------- PRIVATE: lookUp ------------------------------
+// classOf through the form cache
+// Preconditions: TABLE_SIZE < k <= CACHE_SIZE; mask < 2^(k(k-1)/2)
+// Postconditions: Returns the dense class ID of mask
+int Classifier::lookUp(const uint32_t &mask)
+{
+    const uint64_t tag = (uint64_t)(mask + 1) << 32;
+    size_t slot = Random::mix(mask) & (CACHE_SLOTS - 1);
+    for (int probe = 0; probe < CACHE_PROBES; probe++)
+    {
+        const uint64_t entry = cache[slot].load(memory_order_acquire);
+        if (entry == 0)
+            break;
+        if ((entry & ~(uint64_t)UINT32_MAX) == tag)
+            return (int)(uint32_t)entry;
+        slot = (slot + 1) & (CACHE_SLOTS - 1);
+    }
+    
+    unpackMask(mask);
+    const int id = registerClass(k, canonicalKey());
+    insertForm(cache, mask, id);
+    
+    return id;
+}
+
+//----------------------------- PRIVATE: unpackMask ----------------------------
+// Copy the graph with packed upper triangle mask into adjacency
+// Preconditions: mask < 2^(k(k-1)/2)
+// Postconditions: adjacency holds the graph in nauty's bit order
+void Classifier::unpackMask(const uint32_t &mask)
+{
+    fill(adjacency.begin(), adjacency.end(), 0);
+    int t = 0;
+    for (int j = 1; j < k; j++)
+        for (int i = 0; i < j; i++, t++)
+            if (mask >> t & 1)
+            {
+                adjacency[i] |= (uint64_t)1 << (WORDSIZE - 1 - j);
+                adjacency[j] |= (uint64_t)1 << (WORDSIZE - 1 - i);
+            }
+}
+
+//------------------------------ PRIVATE: tabulate -----------------------------
+// Classify every labeled graph on k vertices
+// Preconditions: k <= TABLE_SIZE
+// Postconditions: ids maps every mask to its dense class ID
+void Classifier::tabulate(vector<uint16_t> &ids)
+{
+    const int bits = k * (k - 1) / 2;
+    ids.assign((size_t)1 << bits, 0);
+    for (uint32_t mask = 0; mask < ((uint32_t)1 << bits); mask++)
+    {
+        unpackMask(mask);
+        ids[mask] = (uint16_t)registerClass(k, canonicalKey());
+    }
+}
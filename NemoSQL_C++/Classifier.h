@@ -0,0 +1,192 @@
+//------------------------------------------------------------------------------
+//  Classifier.h
+//------------------------------------------------------------------------------
+// Classifier finds the isomorphism class of a small graph with nauty, linked
+// in-process, so that a motif census needs no labelg subprocess and no text
+// round trip. A graph of k vertices is given as k adjacency rows, bit j of
+// row i set when vertices i and j are adjacent. Its class is identified by
+// a ClassKey: the upper triangle of the adjacency matrix of its canonical
+// labeling, packed in graph6 order, i.e. bit t holds the t-th pair of
+// (0,1), (0,2), (1,2), (0,3), ... Two graphs have the same key exactly when
+// they are isomorphic, and graph6 turns a key into the label labelg prints.
+//
+// For k up to CACHE_SIZE a graph is also given by its packed upper triangle
+// (the same bit order as a ClassKey, at most 28 bits), and classOf maps it
+// to a dense class ID, so that counts can be kept in a plain array. IDs are
+// handed out per k, in the order the classes are first seen, and are shared
+// by all threads; classKey turns one back into its ClassKey.
+//
+// For k <= TABLE_SIZE the triangle fits in 15 bits, so every labeled graph
+// on k vertices is classified once, when the first Classifier for k is
+// built, into a table shared by all threads. The hot path then needs a
+// single load per subgraph and no nauty at all.
+//
+// For larger k a complete table is too large, and masks go through a cache
+// shared by all threads instead: a fixed, lock-free, open-addressed table
+// holding mask and class ID in one 64-bit word. nauty is called only the
+// first time a labeled form is seen, and the cache can be saved to and
+// loaded from a file so that later runs start warm.
+//
+// nauty is linked as the static library nautyL1.a built from the bundled
+// sources (make nautyL1.a in NemoSQL_Binary/nauty_UNX), i.e. with
+// WORDSIZE=64 and MAXN=WORDSIZE, which is all a subgraph of at most
+// MAX_SIZE vertices needs. That build keeps its work areas in static
+// storage, so calls into nauty are serialized. Compiled with -DUSE_TLS,
+// Classifier is linked with nautyTL1.a instead (make nautyTL1.a), whose
+// work areas are thread-local; each Classifier owns its labeling buffers,
+// and options and stats live on the stack, so the workers of a census
+// label in parallel. nauty_check cannot tell the two libraries apart, so
+// the flag and the library must agree.
+//
+// ASSUMPTIONS:
+//   -- 2 <= k <= MAX_SIZE
+//   -- rows describe a simple undirected graph (symmetric, no loops)
+//
+//------------------------------------------------------------------------------
+
+#ifndef __Classifier__
+#define __Classifier__
+
+#include "Counter.h"
+#include "Random.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// Canonical upper triangle of a graph of at most 16 vertices (120 bits)
+typedef unsigned __int128 ClassKey;
+
+struct ClassKeyHash
+{
+    size_t operator()(const ClassKey &key) const
+    {
+        return Random::mix((uint64_t)key ^ Random::mix((uint64_t)(key >> 64)));
+    }
+};
+
+// Number of subgraphs found in each class
+typedef unordered_map<ClassKey, Counter, ClassKeyHash> ClassCounts;
+
+// Variance sum of the sampled count of each class (see ESUEngine.h)
+typedef unordered_map<ClassKey, double, ClassKeyHash> ClassVariance;
+
+class Classifier
+{
+public:
+    
+    //------------------------------- Constructor ------------------------------
+    // Prepare to classify graphs of k vertices
+    // Preconditions: 2 <= k <= MAX_SIZE
+    // Postconditions: nauty has been checked against the headers it was
+    //                 compiled with
+    explicit Classifier(const int &k);
+    
+    //------------------------------- Destructor -------------------------------
+    // Destructor for class Classifier
+    // Preconditions: None
+    // Postconditions: None
+    ~Classifier();
+    
+    
+    //-------------------------------- classify --------------------------------
+    // Isomorphism class of the graph with adjacency rows[0 .. k-1]
+    // Preconditions: Bit j of rows[i] is set when i and j are adjacent
+    // Postconditions: Returns the ClassKey of its canonical labeling
+    ClassKey classify(const uint64_t *rows);
+    
+    //--------------------------------- classOf --------------------------------
+    // Dense class ID of the graph with packed upper triangle mask
+    // Preconditions: k <= CACHE_SIZE; mask < 2^(k(k-1)/2)
+    // Postconditions: Returns an ID below classLimit(k); isomorphic graphs,
+    //                 and only those, share an ID. For k > TABLE_SIZE the
+    //                 form is cached if there is room.
+    int classOf(const uint32_t &mask)
+    {
+        return table != nullptr ? table[mask] : lookUp(mask);
+    }
+    
+    //-------------------------------- classKey --------------------------------
+    // ClassKey of a dense class ID of graphs on k vertices
+    // Preconditions: id was returned by classOf of a Classifier for k
+    // Postconditions: Returns the key classify gives the class
+    static ClassKey classKey(const int &k, const int &id);
+    
+    //------------------------------- classLimit -------------------------------
+    // Bound on the dense class IDs for k, the number of graphs on k vertices
+    // up to isomorphism
+    // Preconditions: k <= CACHE_SIZE
+    // Postconditions: Every ID classOf returns for k is below the result
+    static int classLimit(const int &k);
+    
+    //--------------------------------- graph6 ---------------------------------
+    // graph6 string of the canonical graph of a class of k-vertex graphs
+    // Preconditions: key was returned by a Classifier for k
+    // Postconditions: Returns the label labelg gives the class
+    static string graph6(const ClassKey &key, const int &k);
+    
+    //-------------------------------- loadCache -------------------------------
+    // Fill the canonical form cache for k from a file saved by saveCache
+    // Preconditions: TABLE_SIZE < k <= CACHE_SIZE; no Classifier for k is
+    //                classifying concurrently
+    // Postconditions: Returns false, leaving the cache and the class IDs as
+    //                 they were, if filename is missing, is not a cache for
+    //                 k, pairs a mask with a key that is not its canonical
+    //                 form, or would register more classes than there are
+    static bool loadCache(const string &filename, const int &k);
+    
+    //-------------------------------- saveCache -------------------------------
+    // Write the canonical form cache for k to a file
+    // Preconditions: TABLE_SIZE < k <= CACHE_SIZE; no Classifier for k is
+    //                classifying concurrently
+    // Postconditions: Returns false if filename could not be written
+    static bool saveCache(const string &filename, const int &k);
+    
+    static const int MAX_SIZE = 16;         // largest k a ClassKey holds
+    static const int TABLE_SIZE = 6;        // largest k with a lookup table
+    static const int CACHE_SIZE = 8;        // largest k with a form cache
+    
+    
+private:
+    const int k;                            // vertices per graph
+    
+    // nauty's arguments, one word per row since k <= WORDSIZE
+    vector<uint64_t> adjacency;             // input graph, nauty bit order
+    vector<uint64_t> canonical;             // canonically labeled graph
+    vector<int> lab;                        // canonical labeling
+    vector<int> ptn;                        // partition, all one cell
+    vector<int> orbits;                     // automorphism orbits
+    
+    const uint16_t *table = nullptr;        // class ID of every mask
+    atomic<uint64_t> *cache = nullptr;      // shared form cache for k
+    
+    
+    //------------------------- PRIVATE: canonicalKey -------------------------
+    // Label the graph in adjacency canonically with nauty
+    // Preconditions: adjacency holds the graph in nauty's bit order
+    // Postconditions: Returns the ClassKey of the canonical graph
+    ClassKey canonicalKey();
+    
+    //----------------------------- PRIVATE: lookUp ----------------------------
+    // classOf through the form cache
+    // Preconditions: TABLE_SIZE < k <= CACHE_SIZE; mask < 2^(k(k-1)/2)
+    // Postconditions: Returns the dense class ID of mask
+    int lookUp(const uint32_t &mask);
+    
+    //--------------------------- PRIVATE: unpackMask --------------------------
+    // Copy the graph with packed upper triangle mask into adjacency
+    // Preconditions: mask < 2^(k(k-1)/2)
+    // Postconditions: adjacency holds the graph in nauty's bit order
+    void unpackMask(const uint32_t &mask);
+    
+    //---------------------------- PRIVATE: tabulate ---------------------------
+    // Classify every labeled graph on k vertices
+    // Preconditions: k <= TABLE_SIZE
+    // Postconditions: ids maps every mask to its dense class ID
+    void tabulate(vector<uint16_t> &ids);
+};
+
+#endif /* defined(__Classifier__) */
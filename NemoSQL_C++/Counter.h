@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------
+//  Counter.h
+//------------------------------------------------------------------------------
+// Counter is an overflow-safe subgraph count. It adds in 64 bits, and only
+// when an addition carries out of them does the count continue into a
+// second, high word, so a count is exact up to 2^128 - 1 while the common
+// case costs one add and a never-taken branch.
+//
+// ASSUMPTIONS:
+//   -- Counts never exceed 2^128 - 1
+//
+//------------------------------------------------------------------------------
+
+#ifndef __Counter__
+#define __Counter__
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+class Counter
+{
+public:
+    
+    //------------------------------- Constructor ------------------------------
+    // A count of value
+    // Preconditions: None
+    // Postconditions: The count fits in the low word
+    Counter(uint64_t value = 0) : low(value), high(0) {}
+    
+    //------------------------------- Constructor ------------------------------
+    // The count high * 2^64 + low
+    // Preconditions: None
+    // Postconditions: lowWord() == low and highWord() == high
+    Counter(uint64_t low, uint64_t high) : low(low), high(high) {}
+    
+    //------------------------------- operator+= -------------------------------
+    // Add value to the count
+    // Preconditions: None
+    // Postconditions: A carry out of the low word goes to the high word
+    Counter &operator+=(const uint64_t &value)
+    {
+        if (__builtin_add_overflow(low, value, &low))
+            high++;
+        return *this;
+    }
+    
+    Counter &operator+=(const Counter &other)
+    {
+        high += other.high;
+        return *this += other.low;
+    }
+    
+    //------------------------------- operator-= -------------------------------
+    // Subtract value from the count
+    // Preconditions: value is at most the count
+    // Postconditions: A borrow out of the low word comes from the high word
+    Counter &operator-=(const uint64_t &value)
+    {
+        if (__builtin_sub_overflow(low, value, &low))
+            high--;
+        return *this;
+    }
+    
+    //------------------------------- operator== -------------------------------
+    // Compare two counts
+    // Preconditions: None
+    // Postconditions: Returns true if both words are equal
+    bool operator==(const Counter &other) const
+    {
+        return low == other.low && high == other.high;
+    }
+    bool operator!=(const Counter &other) const { return !(*this == other); }
+    
+    //-------------------------------- operator< -------------------------------
+    // Order two counts
+    // Preconditions: None
+    // Postconditions: Returns true if this count is the smaller
+    bool operator<(const Counter &other) const
+    {
+        return high != other.high ? high < other.high : low < other.low;
+    }
+    
+    //---------------------------------- wide ----------------------------------
+    // Whether the count has outgrown 64 bits
+    // Preconditions: None
+    // Postconditions: Returns true if the high word is in use
+    bool wide() const { return high != 0; }
+    
+    //--------------------------------- words ----------------------------------
+    // The two 64-bit words of the count
+    // Preconditions: None
+    // Postconditions: The count is highWord() * 2^64 + lowWord()
+    uint64_t lowWord() const { return low; }
+    uint64_t highWord() const { return high; }
+    
+    //--------------------------------- value ----------------------------------
+    // The count as a floating point number, for estimates
+    // Preconditions: None
+    // Postconditions: Returns the nearest double
+    double value() const { return high * 18446744073709551616.0 + low; }
+    
+    //---------------------------------- str -----------------------------------
+    // The count in decimal
+    // Preconditions: None
+    // Postconditions: Returns every digit of the count
+    string str() const
+    {
+        unsigned __int128 rest = ((unsigned __int128)high << 64) | low;
+        string digits;
+        do
+        {
+            digits += (char)('0' + (int)(rest % 10));
+            rest /= 10;
+        } while (rest != 0);
+        reverse(digits.begin(), digits.end());
+        
+        return digits;
+    }
+    
+    
+    //------------------------------- operator<< -------------------------------
+    // Print the count in decimal
+    // Preconditions: None
+    // Postconditions: Every digit of the count is written to output
+    friend ostream &operator<<(ostream &output, const Counter &count)
+    {
+        return output << count.str();
+    }
+    
+    
+private:
+    uint64_t low;                           // count modulo 2^64
+    uint64_t high;                          // carries out of low
+};
+
+#endif /* defined(__Counter__) */
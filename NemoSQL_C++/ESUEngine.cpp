@@ -0,0 +1,719 @@
+//------------------------------------------------------------------------------
+//  ESUEngine.cpp
+//------------------------------------------------------------------------------
+// ESUEngine enumerates the connected size-k subgraphs of a Graph with the
+// ESU algorithm (Wernicke 2006), one root vertex at a time. The recursion of
+// extendSubgraph is replaced by an explicit stack of per-depth frames, and
+// every buffer is sized once in the constructor, so enumerating a root does
+// no heap allocation. When splitting is enabled and other workers are idle,
+// the engine gives away the second half of the unexpanded branches of its
+// top frame as a new subtree task. With sampling enabled the engine runs
+// RAND-ESU and keeps a tree node whose subgraph has s vertices with
+// probability p[s]. With a budget enabled it abandons the current task as
+// soon as the budget is exhausted, or hands its rest back as subtree tasks,
+// as it also does whenever suspending is enabled and asked for.
+//
+// ASSUMPTIONS:
+//   -- The Graph is not modified while an engine built on it is in use
+//   -- 2 <= k
+//
+//------------------------------------------------------------------------------
+
+#include "ESUEngine.h"
+#include <algorithm>
+
+const uint64_t ESUEngine::ALWAYS;
+const long ESUEngine::CHECK_NODES;
+
+//--------------------------------- Constructor --------------------------------
+// Prepare an engine for size-k subgraphs of graph
+// Preconditions: 2 <= k
+// Postconditions: Every per-depth buffer is allocated at its final size
+ESUEngine::ESUEngine(const Graph &graph, const int &k)
+    : graph(graph), k(k), subgraph(k), frames(k)
+{
+    reset();
+}
+
+//---------------------------------- Destructor --------------------------------
+// Destructor for class ESUEngine
+// Preconditions: None
+// Postconditions: None
+ESUEngine::~ESUEngine()
+{}
+
+
+//------------------------------------ reset -----------------------------------
+// Turn every option off and forget what earlier tasks found, keeping the
+// buffers, so that one engine serves run after run
+// Preconditions: No task is in progress
+// Postconditions: The engine is as if newly built on the graph as it is
+//                 now; the buffers are reallocated only if the graph grew
+void ESUEngine::reset()
+{
+    const int n = graph.vertexCount();
+    int maxDegree = 0;
+    for (int v = 0; v < n; v++)
+        maxDegree = max(maxDegree, graph.degree(v));
+    
+    // The slice of depth d holds at most (d + 1) * maxDegree distinct vertices
+    long capacity = 0;
+    for (int d = 0; d < k; d++)
+        capacity += min((long)(d + 1) * maxDegree, (long)n);
+    extension.resize(capacity);
+    stamp.assign(n, 0);
+    
+    idle = nullptr;
+    publish = nullptr;
+    suspend = nullptr;
+    sampling = false;
+    squares = 0.0;
+    classSquares.clear();
+    classifying = false;
+    classes.clear();
+    taskClasses.clear();
+    tally = nullptr;
+    taskTally.clear();
+    masks.clear();
+    exhausted = nullptr;
+    nodes = 0;
+    abandoned = false;
+    keepRemainder = false;
+}
+
+
+//-------------------------------- enumerateRoot -------------------------------
+// Enumerate every size-k subgraph whose lowest vertex is root
+// Preconditions: 0 <= root < graph.vertexCount()
+// Postconditions: Returns the number of subgraphs found
+Counter ESUEngine::enumerateRoot(const int &root)
+{
+    abandoned = false;
+    markRoot(root, true);
+    return expand(0, root);
+}
+
+//-------------------------------- enumerateTask -------------------------------
+// Enumerate every size-k subgraph of a whole root or of a subtree
+// Preconditions: task names a whole root, or was
+//                published by an engine with the same graph and k
+// Postconditions: Returns the number of subgraphs found, not counting
+//                 those of subtrees published while enumerating
+Counter ESUEngine::enumerateTask(const ESUTask &task)
+{
+    abandoned = false;
+    if (task.candidates.empty())
+    {
+        if (!kept(1))
+            return 0;
+        return enumerateRoot(task.root);
+    }
+    
+    // Rebuild the stamps exactly as the pushes that produced the prefix set
+    // them. Every candidate neighbors some member, so it ends up stamped.
+    const int depth = (int)task.prefix.size();
+    markRoot(task.root, false);
+    for (int d = 1; d <= depth; d++)
+    {
+        subgraph[d] = task.prefix[d - 1];
+        frames[d].begin = frames[d].cursor = frames[d].stop = 0;
+        frames[d].end = 0;
+        
+        if (!masks.empty())
+            masks[d] = masks[d - 1] |
+                       linkMask(subgraph[d], d) << d * (d - 1) / 2;
+        
+        const int mark = d + 1;
+        const int *last = graph.neighborEnd(subgraph[d]);
+        for (const int *p = upper_bound(graph.neighborBegin(subgraph[d]),
+                                        last, task.root); p != last; p++)
+            if (stamp[*p] == 0)
+                stamp[*p] = mark;
+    }
+    
+    Frame &top = frames[depth];
+    top.begin = top.cursor = 0;
+    top.stop = task.branches;
+    top.end = (int)task.candidates.size();
+    copy(task.candidates.begin(), task.candidates.end(), extension.begin());
+    
+    return expand(depth, task.root);
+}
+
+//------------------------------- enableSplitting ------------------------------
+// Let the engine publish subtrees while idleWorkers is positive
+// Preconditions: idleWorkers and publish outlive the engine's use
+// Postconditions: Every published task is passed to publish exactly once
+void ESUEngine::enableSplitting(const atomic<int> *idleWorkers,
+                                const function<void(ESUTask &&)> &publish)
+{
+    idle = idleWorkers;
+    this->publish = publish;
+}
+
+//------------------------------- enableSampling -------------------------------
+// Run RAND-ESU with the per-size probabilities p[1 .. k]
+// Preconditions: p.size() == k + 1 and every p[s] is in [0, 1]; p[0] is
+//                ignored
+// Postconditions: Tree nodes are kept with these probabilities, drawing
+//                 from a generator seeded with seed
+void ESUEngine::enableSampling(const vector<double> &p, const uint64_t &seed)
+{
+    sampling = true;
+    keep.assign(k + 1, ALWAYS);
+    drop.assign(k + 1, 0.0);
+    double reach = 1.0;
+    for (int size = 1; size <= k; size++)
+    {
+        keep[size] = Random::threshold(p[size]);
+        drop[size] = reach - reach * p[size];
+        reach *= p[size];
+    }
+    below.assign(k, 0);
+    squares = 0.0;
+    random.reseed(seed);
+    prepareClassVariance();
+}
+
+
+//------------------------------ enableSuspending ------------------------------
+// Let the engine suspend its task whenever suspend is set
+// Preconditions: suspend and publish outlive the engine's use; sampling is
+//                not enabled
+// Postconditions: A suspended task passes its unfinished subtrees to
+//                 publish and returns the count found before
+void ESUEngine::enableSuspending(const atomic<bool> *suspend,
+                                 const function<void(ESUTask &&)> &publish)
+{
+    this->suspend = suspend;
+    this->publish = publish;
+}
+
+//---------------------------- enableClassification ----------------------------
+// Classify every subgraph found from now on
+// Preconditions: k <= Classifier::MAX_SIZE; if k <= Classifier::CACHE_SIZE,
+//                histogram has Classifier::classLimit(k) slots and outlives
+//                the engine's use
+// Postconditions: The subgraphs of completed tasks are added to histogram
+//                 by dense class ID if k <= Classifier::CACHE_SIZE, and
+//                 counted in classCounts() by class otherwise
+void ESUEngine::enableClassification(Histogram &histogram)
+{
+    classifying = true;
+    if (!classifier)
+        classifier.reset(new Classifier(k));
+    rows.assign(2 * k, 0);
+    if (k <= Classifier::CACHE_SIZE)
+    {
+        masks.assign(k - 1, 0);
+        batch.resize(graph.vertexCount());
+        batchMasks.resize(graph.vertexCount());
+        tally = &histogram;
+        taskTally.assign(Classifier::classLimit(k), 0);
+    }
+    prepareClassVariance();
+}
+
+//-------------------------------- enableBudget --------------------------------
+// Report visited tree nodes to exhausted, which returns true to stop
+// Preconditions: exhausted is safe to call from this engine's thread;
+//                publish, if given, outlives the engine's use and sampling
+//                is not enabled
+// Postconditions: exhausted(n) is called after every n = CHECK_NODES
+//                 tree nodes. The task in progress when it returns true is
+//                 abandoned, or with publish, suspended.
+void ESUEngine::enableBudget(const function<bool(long)> &exhausted,
+                             const function<void(ESUTask &&)> &publish)
+{
+    this->exhausted = exhausted;
+    nodes = 0;
+    keepRemainder = (bool)publish;
+    if (keepRemainder)
+        this->publish = publish;
+}
+
+//------------------------------ classVarianceTerms ----------------------------
+// varianceTerm kept separately for the sampled leaves of every class
+// Preconditions: Splitting was not enabled while sampling
+// Postconditions: Returns P^2 times the variance estimate of the scaled count
+//                 of each class found; empty unless both sampling and
+//                 classification are enabled
+ClassVariance ESUEngine::classVarianceTerms() const
+{
+    ClassVariance terms;
+    for (int index = 0; index < (int)classSquares.size(); index++)
+        if (classSquares[index] != 0.0)
+            terms[k <= Classifier::CACHE_SIZE ?
+                  Classifier::classKey(k, index) : indexKeys[index]] =
+                classSquares[index];
+    
+    return terms;
+}
+
+
+//------------------------------- PRIVATE: expand ------------------------------
+// Run the explicit ESU stack down from depth until it is empty
+// Preconditions: frames[0 .. depth] and the stamps describe a valid stack
+// Postconditions: Returns the number of subgraphs found; every stamp and
+//                 frame is cleared again
+Counter ESUEngine::expand(int depth, const int &root)
+{
+    Counter found;
+    const double squaresBefore = squares;
+    
+    while (depth >= 0)
+    {
+        Frame &frame = frames[depth];
+        
+        if (abandoned)
+        {
+            // Unwind: every frame pops without expanding anything more. An
+            // engine that keeps its remainder hands it to publish first.
+            if (keepRemainder)
+                suspendStack(depth, root);
+            else
+                frame.cursor = frame.stop = frame.end;
+        }
+        else if (suspend != nullptr && suspend->load(memory_order_relaxed))
+        {
+            // Every frame is left with nothing to expand, so the loop
+            // unwinds the stack
+            suspendStack(depth, root);
+        }
+        else if (depth == k - 2)
+        {
+            // Every remaining candidate completes a size-k subgraph
+            long leaves = frame.stop - frame.cursor;
+            if (classifying)
+                leaves = classifyLeaves(frame);
+            else if (sampling && keep[k] != ALWAYS)
+            {
+                leaves = 0;
+                for (int i = frame.cursor; i < frame.stop; i++)
+                    leaves += random.chance(keep[k]);
+            }
+            if (sampling)
+            {
+                below[depth] += leaves;
+                squares += leaves * drop[k];
+            }
+            found += leaves;
+            frame.cursor = frame.stop;
+            visit(leaves);
+        }
+        else if (idle != nullptr && frame.stop - frame.cursor >= 2 &&
+                 idle->load(memory_order_relaxed) > 0)
+        {
+            splitFrame(depth, root);
+        }
+        
+        if (frame.cursor == frame.stop)
+        {
+            if (sampling)
+            {
+                const double c = (double)below[depth];
+                squares += c * c * drop[depth + 1];
+                if (depth > 0)
+                    below[depth - 1] += below[depth];
+                below[depth] = 0;
+                if (classifying)
+                    popClasses(depth);
+            }
+            
+            if (depth > 0)
+                popVertex(depth, root);
+            depth--;
+            continue;
+        }
+        
+        int w = extension[frame.cursor++];
+        if (!kept(depth + 2))
+            continue;
+        if (visit(1))
+        {
+            // w is not expanded, so it belongs to the remainder
+            frame.cursor--;
+            continue;
+        }
+        depth++;
+        pushVertex(depth, w, root);
+    }
+    
+    // Clear the root level the same way popVertex clears the others
+    stamp[root] = 0;
+    const int *last = graph.neighborEnd(root);
+    for (const int *p = upper_bound(graph.neighborBegin(root), last, root);
+         p != last; p++)
+        stamp[*p] = 0;
+    
+    // A partial tree says nothing about the variance of a whole one. A task
+    // whose remainder was published is complete but for that remainder.
+    if (abandoned && keepRemainder)
+        abandoned = false;
+    if (abandoned)
+        squares = squaresBefore;
+    if (sampling && classifying)
+    {
+        for (int index : taskIndices)
+        {
+            if (!abandoned)
+                classSquares[index] += taskSquares[index];
+            taskSquares[index] = 0.0;
+        }
+        taskIndices.clear();
+    }
+    
+    if (classifying && exhausted)
+    {
+        if (!abandoned)
+        {
+            for (const pair<const ClassKey, Counter> &entry : taskClasses)
+                classes[entry.first] += entry.second;
+            for (int id = 0; id < (int)taskTally.size(); id++)
+                if (taskTally[id] != 0)
+                    tally->add(id, taskTally[id]);
+        }
+        taskClasses.clear();
+        fill(taskTally.begin(), taskTally.end(), 0);
+    }
+    
+    return found;
+}
+
+//------------------------------ PRIVATE: markRoot -----------------------------
+// Stamp the root and its neighbors above it as depth 0
+// Preconditions: No vertex is stamped
+// Postconditions: frames[0] lists the root's neighbors above it when fill
+//                 is true, and is empty otherwise
+void ESUEngine::markRoot(const int &root, const bool &fill)
+{
+    subgraph[0] = root;
+    Frame &first = frames[0];
+    first.begin = first.cursor = first.stop = first.end = 0;
+    
+    stamp[root] = 1;
+    const int *last = graph.neighborEnd(root);
+    for (const int *p = upper_bound(graph.neighborBegin(root), last, root);
+         p != last; p++)
+    {
+        stamp[*p] = 1;
+        if (fill)
+            extension[first.end++] = *p;
+    }
+    first.stop = first.end;
+}
+
+//----------------------------- PRIVATE: splitFrame ----------------------------
+// Publish the second half of the unexpanded branches of frames[depth]
+// Preconditions: frames[depth] is the top of the stack
+// Postconditions: frames[depth] stops where the published task begins
+void ESUEngine::splitFrame(const int &depth, const int &root)
+{
+    // The branches before middle stay here and still see the published
+    // candidates as later siblings; the task expands the rest, each seeing
+    // only its own later siblings, which is exactly what ESU would do
+    Frame &frame = frames[depth];
+    const int middle = frame.cursor + (frame.stop - frame.cursor) / 2;
+    
+    ESUTask task;
+    task.root = root;
+    task.prefix.assign(subgraph.begin() + 1, subgraph.begin() + depth + 1);
+    task.candidates.assign(extension.begin() + middle,
+                           extension.begin() + frame.end);
+    task.branches = frame.stop - middle;
+    frame.stop = middle;
+    
+    publish(move(task));
+}
+
+//---------------------------- PRIVATE: suspendStack ---------------------------
+// Publish the unexpanded branches of frames[0 .. depth]
+// Preconditions: frames[depth] is the top of the stack
+// Postconditions: No frame has a branch left to expand
+void ESUEngine::suspendStack(const int &depth, const int &root)
+{
+    // The branch in progress at each depth is the next frame up, so what is
+    // left of a frame is exactly its branches from cursor to stop
+    for (int d = 0; d <= depth; d++)
+    {
+        Frame &frame = frames[d];
+        if (frame.cursor < frame.stop)
+        {
+            ESUTask task;
+            task.root = root;
+            task.prefix.assign(subgraph.begin() + 1, subgraph.begin() + d + 1);
+            task.candidates.assign(extension.begin() + frame.cursor,
+                                   extension.begin() + frame.end);
+            task.branches = frame.stop - frame.cursor;
+            publish(move(task));
+        }
+        frame.cursor = frame.stop;
+    }
+}
+
+//--------------------------- PRIVATE: classifyLeaves --------------------------
+// Classify and count the (sampled) leaves of frames[k - 2]
+// Preconditions: classification is enabled and frames[k - 2] is the top of
+//                the stack
+// Postconditions: Returns the number of leaves counted
+long ESUEngine::classifyLeaves(const Frame &frame)
+{
+    if (k <= Classifier::CACHE_SIZE)
+        return tallyLeaves(frame);
+    
+    // rows[0 .. k-2] hold the adjacency of the shared k - 1 vertices, and
+    // rows[k ..] the copy that each leaf completes with its last vertex
+    const int last = k - 1;
+    for (int i = 0; i < last; i++)
+        rows[i] = 0;
+    for (int i = 1; i < last; i++)
+        for (int j = 0; j < i; j++)
+            if (graph.hasEdge(subgraph[i], subgraph[j]))
+            {
+                rows[i] |= (uint64_t)1 << j;
+                rows[j] |= (uint64_t)1 << i;
+            }
+    
+    ClassCounts &target = exhausted ? taskClasses : classes;
+    uint64_t *leaf = rows.data() + k;
+    long leaves = 0;
+    for (int c = frame.cursor; c < frame.stop; c++)
+    {
+        if (sampling && keep[k] != ALWAYS && !random.chance(keep[k]))
+            continue;
+        
+        const int w = extension[c];
+        leaf[last] = 0;
+        for (int j = 0; j < last; j++)
+        {
+            leaf[j] = rows[j];
+            if (graph.hasEdge(w, subgraph[j]))
+            {
+                leaf[j] |= (uint64_t)1 << last;
+                leaf[last] |= (uint64_t)1 << j;
+            }
+        }
+        const ClassKey key = classifier->classify(leaf);
+        target[key] += 1;
+        if (sampling)
+            sampleClass(varianceIndex(key));
+        leaves++;
+    }
+    
+    return leaves;
+}
+
+//---------------------------- PRIVATE: tallyLeaves ----------------------------
+// Count the (sampled) leaves of frames[k - 2] by the dense class ID of their
+// packed upper triangle
+// Preconditions: classification is enabled, k <= Classifier::CACHE_SIZE and
+//                frames[k - 2] is the top of the stack
+// Postconditions: Returns the number of leaves counted
+long ESUEngine::tallyLeaves(const Frame &frame)
+{
+    // The pairs among the shared k - 1 vertices come first in graph6 order
+    // and were packed on the way down, so each leaf only ORs in the pairs
+    // with its last vertex
+    const int last = k - 1;
+    const int shift = last * (last - 1) / 2;
+    const uint32_t prefix = masks[last - 1];
+    
+    // Gather the kept leaves first, so that the links can be filled in one
+    // member at a time: with the bit matrix that is a branch-free load and
+    // shift per leaf, a loop the compiler can vectorize
+    int size = 0;
+    for (int c = frame.cursor; c < frame.stop; c++)
+        if (!sampling || keep[k] == ALWAYS || random.chance(keep[k]))
+        {
+            batch[size] = extension[c];
+            batchMasks[size++] = prefix;
+        }
+    
+    for (int j = 0; j < last; j++)
+    {
+        const uint32_t bit = (uint32_t)1 << (shift + j);
+        const uint64_t *row = graph.adjacencyBits(subgraph[j]);
+        if (row != nullptr)
+            for (int i = 0; i < size; i++)
+                batchMasks[i] |= bit & -(uint32_t)(row[batch[i] >> 6]
+                                                   >> (batch[i] & 63) & 1);
+        else
+            for (int i = 0; i < size; i++)
+                if (graph.hasEdge(batch[i], subgraph[j]))
+                    batchMasks[i] |= bit;
+    }
+    
+    // The leaves are not needed any more: batch holds their classes
+    for (int i = 0; i < size; i++)
+        batch[i] = classifier->classOf(batchMasks[i]);
+    if (exhausted)
+        for (int i = 0; i < size; i++)
+            taskTally[batch[i]] += 1;
+    else
+        for (int i = 0; i < size; i++)
+            tally->add(batch[i]);
+    if (sampling)
+        for (int i = 0; i < size; i++)
+            sampleClass(batch[i]);
+    
+    return size;
+}
+
+//------------------------- PRIVATE: prepareClassVariance ----------------------
+// Size the class variance sums once sampling and classification are both
+// enabled
+// Preconditions: None
+// Postconditions: Every sum is 0; the variance index of a class is its
+//                 dense ID for k <= Classifier::CACHE_SIZE and is handed out
+//                 by varianceIndex otherwise
+void ESUEngine::prepareClassVariance()
+{
+    if (!sampling || !classifying)
+        return;
+    
+    const int classes = k <= Classifier::CACHE_SIZE ?
+                        Classifier::classLimit(k) : 0;
+    classBelow.assign(k, vector<long>(classes, 0));
+    classesBelow.assign(k, vector<int>());
+    for (vector<int> &indices : classesBelow)
+        indices.reserve(classes);
+    taskSquares.assign(classes, 0.0);
+    taskIndices.clear();
+    classSquares.assign(classes, 0.0);
+    classIndex.clear();
+    indexKeys.clear();
+    
+    // Nodes above the first size with p[s] < 1 add nothing, so the leaf
+    // counts need not reach them
+    classTop = k;
+    for (int depth = k - 1; depth >= 0; depth--)
+        if (drop[depth + 1] != 0.0)
+            classTop = depth;
+}
+
+//---------------------------- PRIVATE: varianceIndex --------------------------
+// Variance index of a class, for k above Classifier::CACHE_SIZE
+// Preconditions: prepareClassVariance has sized the sums
+// Postconditions: A class seen for the first time gets the next index, with
+//                 a slot in every sum
+int ESUEngine::varianceIndex(const ClassKey &key)
+{
+    auto found = classIndex.find(key);
+    if (found != classIndex.end())
+        return found->second;
+    
+    const int index = (int)indexKeys.size();
+    classIndex[key] = index;
+    indexKeys.push_back(key);
+    for (vector<long> &counts : classBelow)
+        counts.push_back(0);
+    taskSquares.push_back(0.0);
+    classSquares.push_back(0.0);
+    return index;
+}
+
+//----------------------------- PRIVATE: sampleClass ---------------------------
+// Count a sampled leaf of the class with variance index index
+// Preconditions: frames[k - 2] is the top of the stack
+// Postconditions: The leaf is below depth k - 2
+void ESUEngine::sampleClass(const int &index)
+{
+    if (classTop == k)
+        return;
+    
+    // Its own term, c(u) = 1, is added with the others of its frame when
+    // the frame is popped
+    if (classBelow[k - 2][index]++ == 0)
+        classesBelow[k - 2].push_back(index);
+}
+
+//----------------------------- PRIVATE: popClasses ----------------------------
+// Close the class sums of the tree node at depth as it is popped
+// Preconditions: Sampling and classification are enabled
+// Postconditions: The leaves of depth are moved to depth - 1 if nodes there
+//                 add to the sums
+void ESUEngine::popClasses(const int &depth)
+{
+    // The leaves of the leaf frame add drop[k] each
+    vector<long> &counts = classBelow[depth];
+    const double leaf = depth == k - 2 ? drop[k] : 0.0;
+    for (int index : classesBelow[depth])
+    {
+        const double c = (double)counts[index];
+        addClassSquare(index, c * leaf + c * c * drop[depth + 1]);
+        if (depth > classTop)
+        {
+            long &parent = classBelow[depth - 1][index];
+            if (parent == 0)
+                classesBelow[depth - 1].push_back(index);
+            parent += counts[index];
+        }
+        counts[index] = 0;
+    }
+    classesBelow[depth].clear();
+}
+
+//------------------------------ PRIVATE: linkMask -----------------------------
+// Which of the members subgraph[0 .. depth-1] w is adjacent to
+// Preconditions: 0 <= depth < k
+// Postconditions: Bit j of the result is set when w neighbors subgraph[j]
+uint32_t ESUEngine::linkMask(const int &w, const int &depth) const
+{
+    uint32_t links = 0;
+    for (int j = 0; j < depth; j++)
+        if (graph.hasEdge(w, subgraph[j]))
+            links |= (uint32_t)1 << j;
+    
+    return links;
+}
+
+//----------------------------- PRIVATE: pushVertex ----------------------------
+// Add w at depth, building the extension slice of depth from the unused
+// part of the parent's slice and w's exclusive neighbors above root
+// Preconditions: 1 <= depth < k - 1 and w is a candidate of depth - 1
+// Postconditions: subgraph[depth] == w and frames[depth] is ready; so is
+//                 masks[depth] if masks are kept
+void ESUEngine::pushVertex(const int &depth, const int &w, const int &root)
+{
+    const Frame &parent = frames[depth - 1];
+    Frame &frame = frames[depth];
+    
+    subgraph[depth] = w;
+    if (!masks.empty())
+        masks[depth] = masks[depth - 1] |
+                       linkMask(w, depth) << depth * (depth - 1) / 2;
+    frame.begin = frame.cursor = frame.end = parent.end;
+    
+    for (int i = parent.cursor; i < parent.end; i++)
+        extension[frame.end++] = extension[i];
+    
+    const int mark = depth + 1;
+    const int *last = graph.neighborEnd(w);
+    for (const int *p = upper_bound(graph.neighborBegin(w), last, root);
+         p != last; p++)
+    {
+        if (stamp[*p] == 0)
+        {
+            stamp[*p] = mark;
+            extension[frame.end++] = *p;
+        }
+    }
+    frame.stop = frame.end;
+}
+
+//----------------------------- PRIVATE: popVertex -----------------------------
+// Undo pushVertex for the vertex at depth
+// Preconditions: subgraph[depth] was added by pushVertex
+// Postconditions: Every stamp set at depth is cleared
+void ESUEngine::popVertex(const int &depth, const int &root)
+{
+    const int mark = depth + 1;
+    const int w = subgraph[depth];
+    const int *last = graph.neighborEnd(w);
+    for (const int *p = upper_bound(graph.neighborBegin(w), last, root);
+         p != last; p++)
+    {
+        if (stamp[*p] == mark)
+            stamp[*p] = 0;
+    }
+}
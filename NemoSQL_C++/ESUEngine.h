@@ -0,0 +1,402 @@
+//------------------------------------------------------------------------------
+//  ESUEngine.h
+//------------------------------------------------------------------------------
+// ESUEngine enumerates the connected size-k subgraphs of a Graph with the
+// ESU algorithm (Wernicke 2006), one root vertex at a time. The recursion of
+// extendSubgraph is replaced by an explicit stack of per-depth frames, and
+// every buffer is sized once in the constructor, so enumerating a root does
+// no heap allocation. An engine can be reset and reused for another run,
+// keeping its buffers.
+//
+//   -- subgraph[d] is the vertex added at depth d (subgraph[0] is the root)
+//   -- the extension of every depth is a slice of one flat stack; a child's
+//      slice is pushed directly above its parent's
+//   -- stamp[u] is the depth at which u joined the closed neighborhood of
+//      the current subgraph, or 0. A vertex is an exclusive neighbor of the
+//      vertex being added exactly when its stamp is still 0, and popping a
+//      depth clears only the stamps that depth set.
+//
+// Work is handed to the engine as ESUTasks. A task is either a whole root or
+// a subtree: a subgraph prefix together with the part of its extension that
+// is still unexpanded. When splitting is enabled and other workers are idle,
+// the engine gives away the second half of the unexpanded branches of its
+// top frame as a new subtree task, so one hub does not keep a single worker
+// busy long after the others have finished. A branch's child extension also
+// holds every later sibling, so a split frame keeps all of its slots and
+// only stops expanding where the published branches begin.
+//
+// With sampling enabled the engine runs RAND-ESU: a tree node whose subgraph
+// has s vertices is kept with probability p[s] (p[1] for the root itself,
+// p[k] for the leaves), so every size-k subgraph is found with probability
+// P = p[1] * ... * p[k]. The engine also accumulates the Horvitz-Thompson
+// variance of the scaled count: two leaves whose deepest common tree node
+// has s vertices are found together with probability P * P / A[s], where
+// A[s] = p[1] * ... * p[s], which sums over the tree to
+//
+//     Var = (1 / P^2) * sum over kept nodes u of c(u)^2 * (A[s(u)-1] - A[s(u)])
+//
+// with c(u) the number of sampled leaves below u (1 for a leaf) and A[0] = 1.
+// The sum is only complete for whole roots, so sampled runs must not split.
+// A classifying engine keeps the same sum for every class, with c(u) the
+// number of sampled leaves of that class below u: the leaf counts of each
+// depth are kept by class too, for the classes that occur below it.
+//
+// With a budget enabled the engine reports the number of tree nodes it has
+// visited every CHECK_NODES nodes. Once the budget says it is exhausted, the
+// current task is cut short. An exact engine given a publish callback
+// suspends it, as below, so the work already done is kept and the rest is
+// published. Otherwise the stack is unwound without expanding anything more
+// and aborted() turns true, and the whole task must be run again; sampled
+// engines need this, since the variance sum needs whole trees.
+//
+// With suspending enabled the engine, once asked to, publishes the
+// unexpanded branches of every frame on its stack as subtree tasks and
+// returns what it has found so far. Together the published tasks cover
+// exactly the rest of the task, so a census can stop, save them and carry on
+// later. Sampled engines are never suspended, since the variance sum needs
+// whole trees.
+//
+// ASSUMPTIONS:
+//   -- The Graph is not modified while an engine built on it is in use
+//   -- 2 <= k
+//
+//------------------------------------------------------------------------------
+
+#ifndef __ESUEngine__
+#define __ESUEngine__
+
+#include "Classifier.h"
+#include "Counter.h"
+#include "Graph.h"
+#include "Histogram.h"
+#include "Random.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// A unit of ESU work. A whole root has empty prefix and candidates and costs
+// no allocation; a subtree lists the vertices added after the root and the
+// unexpanded tail of that subgraph's extension, of which only the first
+// branches candidates are expanded by this task. The candidates after them
+// belong to other tasks but are still later siblings of these branches.
+struct ESUTask
+{
+    int root = -1;                          // lowest vertex of the subgraphs
+    vector<int> prefix;                     // subgraph[1 ..] of a subtree
+    vector<int> candidates;                 // unexpanded extension tail
+    int branches = 0;                       // leading candidates to expand
+};
+
+class ESUEngine
+{
+public:
+    
+    //------------------------------- Constructor ------------------------------
+    // Prepare an engine for size-k subgraphs of graph
+    // Preconditions: 2 <= k
+    // Postconditions: Every per-depth buffer is allocated at its final size
+    ESUEngine(const Graph &graph, const int &k);
+    
+    //------------------------------- Destructor -------------------------------
+    // Destructor for class ESUEngine
+    // Preconditions: None
+    // Postconditions: None
+    ~ESUEngine();
+    
+    //---------------------------------- reset ---------------------------------
+    // Turn every option off and forget what earlier tasks found, keeping the
+    // buffers, so that one engine serves run after run
+    // Preconditions: No task is in progress
+    // Postconditions: The engine is as if newly built on the graph as it is
+    //                 now; the buffers are reallocated only if the graph
+    //                 grew
+    void reset();
+    
+    
+    //------------------------------ enumerateRoot -----------------------------
+    // Enumerate every size-k subgraph whose lowest vertex is root
+    // Preconditions: 0 <= root < graph.vertexCount()
+    // Postconditions: Returns the number of subgraphs found
+    Counter enumerateRoot(const int &root);
+    
+    //------------------------------ enumerateTask -----------------------------
+    // Enumerate every size-k subgraph of a whole root or of a subtree
+    // Preconditions: task names a whole root, or was
+    //                published by an engine with the same graph and k
+    // Postconditions: Returns the number of subgraphs found, not counting
+    //                 those of subtrees published while enumerating
+    Counter enumerateTask(const ESUTask &task);
+    
+    //------------------------------ enableSplitting ---------------------------
+    // Let the engine publish subtrees while idleWorkers is positive
+    // Preconditions: idleWorkers and publish outlive the engine's use
+    // Postconditions: Every published task is passed to publish exactly once
+    void enableSplitting(const atomic<int> *idleWorkers,
+                         const function<void(ESUTask &&)> &publish);
+    
+    //------------------------------ enableSampling ----------------------------
+    // Run RAND-ESU with the per-size probabilities p[1 .. k]
+    // Preconditions: p.size() == k + 1 and every p[s] is in [0, 1]; p[0] is
+    //                ignored
+    // Postconditions: Tree nodes are kept with these probabilities, drawing
+    //                 from a generator seeded with seed
+    void enableSampling(const vector<double> &p, const uint64_t &seed);
+    
+    //----------------------------- enableSuspending ---------------------------
+    // Let the engine suspend its task whenever suspend is set
+    // Preconditions: suspend and publish outlive the engine's use; sampling
+    //                is not enabled
+    // Postconditions: A suspended task passes its unfinished subtrees to
+    //                 publish and returns the count found before
+    void enableSuspending(const atomic<bool> *suspend,
+                          const function<void(ESUTask &&)> &publish);
+    
+    //--------------------------- enableClassification -------------------------
+    // Classify every subgraph found from now on
+    // Preconditions: k <= Classifier::MAX_SIZE; if k <= Classifier::CACHE_SIZE,
+    //                histogram has Classifier::classLimit(k) slots and
+    //                outlives the engine's use
+    // Postconditions: The subgraphs of completed tasks are added to
+    //                 histogram by dense class ID if k is at most
+    //                 Classifier::CACHE_SIZE, and counted in classCounts() by
+    //                 class otherwise
+    void enableClassification(Histogram &histogram);
+    
+    //------------------------------- classCounts ------------------------------
+    // Subgraphs found by the completed tasks, by class
+    // Preconditions: None
+    // Postconditions: Empty unless classification is enabled and k is above
+    //                 Classifier::CACHE_SIZE
+    const ClassCounts &classCounts() const { return classes; }
+    
+    //------------------------------- enableBudget -----------------------------
+    // Report visited tree nodes to exhausted, which returns true to stop
+    // Preconditions: exhausted is safe to call from this engine's thread;
+    //                publish, if given, outlives the engine's use and
+    //                sampling is not enabled
+    // Postconditions: exhausted(n) is called after every n = CHECK_NODES
+    //                 tree nodes. The task in progress when it returns true
+    //                 is abandoned; with publish it is suspended instead,
+    //                 passing its unexpanded branches to publish and
+    //                 returning the count found before.
+    void enableBudget(const function<bool(long)> &exhausted,
+                      const function<void(ESUTask &&)> &publish = nullptr);
+    
+    //--------------------------------- aborted --------------------------------
+    // Whether the last task was abandoned because the budget ran out
+    // Preconditions: None
+    // Postconditions: Returns true if the count of the last task is partial
+    bool aborted() const { return abandoned; }
+    
+    //------------------------------ varianceTerm ------------------------------
+    // Sum of c(u)^2 * (A[s(u)-1] - A[s(u)]) over the kept tree nodes of every
+    // root enumerated so far
+    // Preconditions: Splitting was not enabled while sampling
+    // Postconditions: Returns P^2 times the variance estimate of the scaled
+    //                 count, or 0 without sampling
+    double varianceTerm() const { return squares; }
+    
+    //--------------------------- classVarianceTerms ---------------------------
+    // varianceTerm kept separately for the sampled leaves of every class
+    // Preconditions: Splitting was not enabled while sampling
+    // Postconditions: Returns P^2 times the variance estimate of the scaled
+    //                 count of each class found; empty unless both sampling
+    //                 and classification are enabled
+    ClassVariance classVarianceTerms() const;
+    
+    
+private:
+    
+    // One level of the explicit ESU stack
+    struct Frame
+    {
+        int begin;                          // first extension slot
+        int cursor;                         // next candidate to expand
+        int stop;                           // one past the last to expand
+        int end;                            // one past the last slot
+    };
+    
+    const Graph &graph;                     // graph being enumerated
+    const int k;                            // subgraph size
+    
+    vector<int> subgraph;                   // current members by depth
+    vector<Frame> frames;                   // extension slice of each depth
+    vector<int> extension;                  // flat stack of extension slices
+    vector<int> stamp;                      // depth that marked each vertex
+    
+    const atomic<int> *idle = nullptr;      // workers waiting for tasks
+    function<void(ESUTask &&)> publish;     // receives split subtrees
+    const atomic<bool> *suspend = nullptr;  // set to suspend the task
+    
+    bool sampling = false;                  // RAND-ESU instead of ESU
+    vector<uint64_t> keep;                  // Random::threshold of each p[s]
+    Random random;                          // draws of this engine
+    vector<double> drop;                    // A[s-1] - A[s] by size s
+    vector<long> below;                     // sampled leaves under each depth
+    double squares = 0.0;                   // see varianceTerm
+    vector<vector<long>> classBelow;        // below, by variance index
+    vector<vector<int>> classesBelow;       // indices of each depth in use
+    vector<double> taskSquares;             // class sums of the task so far
+    vector<int> taskIndices;                // indices in taskSquares in use
+    vector<double> classSquares;            // see classVarianceTerms
+    unordered_map<ClassKey, int, ClassKeyHash> classIndex;
+    vector<ClassKey> indexKeys;             // class of each variance index
+    int classTop = 0;                       // first depth adding to the sums
+    
+    bool classifying = false;               // classify leaves
+    unique_ptr<Classifier> classifier;      // kept once made
+    ClassCounts classes;                    // see classCounts
+    ClassCounts taskClasses;                // classes of an abandonable task
+    Histogram *tally = nullptr;             // counts by dense class ID
+    vector<Counter> taskTally;              // tally of an abandonable task
+    vector<uint64_t> rows;                  // adjacency of the subgraph
+    vector<uint32_t> masks;                 // packed triangle by depth
+    vector<int> batch;                      // kept leaves of a leaf frame
+    vector<uint32_t> batchMasks;            // packed triangle of each
+    
+    function<bool(long)> exhausted;         // budget callback, if any
+    long nodes = 0;                         // tree nodes since last report
+    bool abandoned = false;                 // last task was cut short
+    bool keepRemainder = false;             // suspend, not abandon, on budget
+    
+    static const long CHECK_NODES = 4096;   // nodes between budget reports
+    
+    
+    //----------------------------- PRIVATE: visit -----------------------------
+    // Account for count tree nodes against the budget
+    // Preconditions: None
+    // Postconditions: Returns true, and sets abandoned, once the budget is
+    //                 exhausted
+    bool visit(const long &count)
+    {
+        if (!exhausted || (nodes += count) < CHECK_NODES)
+            return abandoned;
+        
+        if (exhausted(nodes))
+            abandoned = true;
+        nodes = 0;
+        return abandoned;
+    }
+    
+    //----------------------------- PRIVATE: kept ------------------------------
+    // Draw whether a tree node whose subgraph has size vertices is kept
+    // Preconditions: 1 <= size <= k
+    // Postconditions: Always true without sampling or when p[size] is 1
+    bool kept(const int &size)
+    {
+        return !sampling || keep[size] == ALWAYS || random.chance(keep[size]);
+    }
+    
+    static const uint64_t ALWAYS = ~(uint64_t)0;
+    
+    
+    //----------------------------- PRIVATE: expand ----------------------------
+    // Run the explicit ESU stack down from depth until it is empty
+    // Preconditions: frames[0 .. depth] and the stamps describe a valid stack
+    // Postconditions: Returns the number of subgraphs found; every stamp and
+    //                 frame is cleared again
+    Counter expand(int depth, const int &root);
+    
+    //---------------------------- PRIVATE: markRoot ---------------------------
+    // Stamp the root and its neighbors above it as depth 0
+    // Preconditions: No vertex is stamped
+    // Postconditions: frames[0] lists the root's neighbors above it when fill
+    //                 is true, and is empty otherwise
+    void markRoot(const int &root, const bool &fill);
+    
+    //--------------------------- PRIVATE: splitFrame --------------------------
+    // Publish the second half of the unexpanded branches of frames[depth]
+    // Preconditions: frames[depth] is the top of the stack
+    // Postconditions: frames[depth] stops where the published task begins
+    void splitFrame(const int &depth, const int &root);
+    
+    //------------------------- PRIVATE: suspendStack --------------------------
+    // Publish the unexpanded branches of frames[0 .. depth]
+    // Preconditions: frames[depth] is the top of the stack
+    // Postconditions: No frame has a branch left to expand
+    void suspendStack(const int &depth, const int &root);
+    
+    
+    //------------------------- PRIVATE: classifyLeaves ------------------------
+    // Classify and count the (sampled) leaves of frames[k - 2]
+    // Preconditions: classification is enabled and frames[k - 2] is the top
+    //                of the stack
+    // Postconditions: Returns the number of leaves counted
+    long classifyLeaves(const Frame &frame);
+    
+    //-------------------------- PRIVATE: tallyLeaves --------------------------
+    // Count the (sampled) leaves of frames[k - 2] by the class of their
+    // packed upper triangle
+    // Preconditions: classification is enabled, k <= Classifier::CACHE_SIZE
+    //                and frames[k - 2] is the top of the stack
+    // Postconditions: Returns the number of leaves counted
+    long tallyLeaves(const Frame &frame);
+    
+    //----------------------- PRIVATE: prepareClassVariance --------------------
+    // Size the class variance sums once sampling and classification are
+    // both enabled
+    // Preconditions: None
+    // Postconditions: Every sum is 0; the variance index of a class is its
+    //                 dense ID for k <= Classifier::CACHE_SIZE and is
+    //                 handed out by varianceIndex otherwise
+    void prepareClassVariance();
+    
+    //-------------------------- PRIVATE: varianceIndex ------------------------
+    // Variance index of a class, for k above Classifier::CACHE_SIZE
+    // Preconditions: prepareClassVariance has sized the sums
+    // Postconditions: A class seen for the first time gets the next index,
+    //                 with a slot in every sum
+    int varianceIndex(const ClassKey &key);
+    
+    //--------------------------- PRIVATE: sampleClass -------------------------
+    // Count a sampled leaf of the class with variance index index
+    // Preconditions: frames[k - 2] is the top of the stack
+    // Postconditions: The leaf is below depth k - 2
+    void sampleClass(const int &index);
+    
+    //------------------------- PRIVATE: addClassSquare ------------------------
+    // Add to the task's variance sum of the class with variance index index
+    // Preconditions: None
+    // Postconditions: The index is listed in taskIndices if its sum is used
+    void addClassSquare(const int &index, const double &value)
+    {
+        if (value == 0.0)
+            return;
+        if (taskSquares[index] == 0.0)
+            taskIndices.push_back(index);
+        taskSquares[index] += value;
+    }
+    
+    //--------------------------- PRIVATE: popClasses --------------------------
+    // Close the class sums of the tree node at depth as it is popped
+    // Preconditions: Sampling and classification are enabled
+    // Postconditions: The leaves of depth are moved to depth - 1 if nodes
+    //                 there add to the sums
+    void popClasses(const int &depth);
+    
+    //---------------------------- PRIVATE: linkMask ---------------------------
+    // Which of the members subgraph[0 .. depth-1] w is adjacent to
+    // Preconditions: 0 <= depth < k
+    // Postconditions: Bit j of the result is set when w neighbors subgraph[j]
+    uint32_t linkMask(const int &w, const int &depth) const;
+    
+    //--------------------------- PRIVATE: pushVertex --------------------------
+    // Add w at depth, building the extension slice of depth from the unused
+    // part of the parent's slice and w's exclusive neighbors above root
+    // Preconditions: 1 <= depth < k - 1 and w is a candidate of depth - 1
+    // Postconditions: subgraph[depth] == w and frames[depth] is ready; so is
+    //                 masks[depth] if masks are kept
+    void pushVertex(const int &depth, const int &w, const int &root);
+    
+    //--------------------------- PRIVATE: popVertex ---------------------------
+    // Undo pushVertex for the vertex at depth
+    // Preconditions: subgraph[depth] was added by pushVertex
+    // Postconditions: Every stamp set at depth is cleared
+    void popVertex(const int &depth, const int &root);
+};
+
+#endif /* defined(__ESUEngine__) */
@@ -0,0 +1,155 @@
+//------------------------------------------------------------------------------
+//  EdgeSet.h
+//------------------------------------------------------------------------------
+// EdgeSet is a set of undirected edges: the hash edge index of a Graph too
+// large for a bit matrix, and the changing edges of the random graphs of a
+// Randomizer. An edge u-v is stored as one 64-bit key in an open-addressed
+// table that is probed linearly and kept at most half full, so membership,
+// insertion and removal take constant time. Probing starts on an aligned
+// group of four slots, and a lookup tests a whole group at once, which
+// compiles to vector compares. A removal shifts later keys of its probe run
+// back into the hole instead of leaving a tombstone, so the table never
+// fills up however long the edges keep changing.
+//
+// ASSUMPTIONS:
+//   -- Vertex IDs are non-negative ints
+//   -- The number of edges never exceeds the capacity given to reset
+//
+//------------------------------------------------------------------------------
+
+#ifndef __EdgeSet__
+#define __EdgeSet__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+class EdgeSet
+{
+public:
+    
+    //---------------------------------- reset ---------------------------------
+    // Empty the set and make room for edges edges
+    // Preconditions: None
+    // Postconditions: The set is empty, at most half full at edges edges
+    void reset(const size_t &edges)
+    {
+        size_t slots = 8;
+        while (slots < 2 * edges)
+            slots <<= 1;
+        keys.assign(slots, (uint64_t)EMPTY_KEY);
+        mask = slots - 1;
+    }
+    
+    //--------------------------------- release --------------------------------
+    // Free the table
+    // Preconditions: None
+    // Postconditions: allocated() is false until the next reset
+    void release()
+    {
+        keys.clear();
+        keys.shrink_to_fit();
+        mask = 0;
+    }
+    
+    //-------------------------------- allocated -------------------------------
+    // Whether the set has a table
+    // Preconditions: None
+    // Postconditions: Returns true if reset was called since any release
+    bool allocated() const { return !keys.empty(); }
+    
+    //-------------------------------- contains --------------------------------
+    // Check whether u-v is in the set
+    // Preconditions: allocated()
+    // Postconditions: Returns true if u-v or v-u was inserted and not erased
+    bool contains(const int &u, const int &v) const
+    {
+        // Every slot from a key's home up to the key is full, so the first
+        // group with an empty slot ends the search
+        const uint64_t key = edgeKey(u, v);
+        for (uint64_t slot = home(key); ; slot = (slot + GROUP) & mask)
+        {
+            const uint64_t *group = keys.data() + slot;
+            bool found = false, open = false;
+            for (int i = 0; i < GROUP; i++)
+            {
+                found |= group[i] == key;
+                open |= group[i] == EMPTY_KEY;
+            }
+            if (found || open)
+                return found;
+        }
+    }
+    
+    //--------------------------------- insert ---------------------------------
+    // Add u-v to the set
+    // Preconditions: allocated(); u-v is not in the set
+    // Postconditions: u-v is in the set
+    void insert(const int &u, const int &v)
+    {
+        const uint64_t key = edgeKey(u, v);
+        uint64_t slot = home(key);
+        while (keys[slot] != EMPTY_KEY)
+            slot = (slot + 1) & mask;
+        keys[slot] = key;
+    }
+    
+    //---------------------------------- erase ---------------------------------
+    // Remove u-v from the set
+    // Preconditions: allocated(); u-v is in the set
+    // Postconditions: u-v is not in the set; every other edge still is
+    void erase(const int &u, const int &v)
+    {
+        const uint64_t key = edgeKey(u, v);
+        uint64_t hole = home(key);
+        while (keys[hole] != key)
+            hole = (hole + 1) & mask;
+    
+        // A later key of the run may fill the hole when its home slot does
+        // not lie after the hole, i.e. it is at least as far from its home
+        // as from the hole
+        for (uint64_t slot = (hole + 1) & mask; keys[slot] != EMPTY_KEY;
+             slot = (slot + 1) & mask)
+        {
+            if (((slot - home(keys[slot])) & mask) >= ((slot - hole) & mask))
+            {
+                keys[hole] = keys[slot];
+                hole = slot;
+            }
+        }
+        keys[hole] = EMPTY_KEY;
+    }
+    
+    
+private:
+    vector<uint64_t> keys;                  // open-addressed edge keys
+    uint64_t mask = 0;                      // keys.size() - 1
+    
+    static const uint64_t EMPTY_KEY = ~(uint64_t)0;
+    static const int GROUP = 4;             // slots a lookup tests at once
+    
+    
+    //---------------------------- PRIVATE: edgeKey ----------------------------
+    // Key of the undirected edge u-v
+    // Preconditions: None
+    // Postconditions: Returns the same key for u-v and v-u
+    static uint64_t edgeKey(const int &u, const int &v)
+    {
+        return u < v ? ((uint64_t)u << 32) | (uint32_t)v
+                     : ((uint64_t)v << 32) | (uint32_t)u;
+    }
+    
+    //----------------------------- PRIVATE: home ------------------------------
+    // First slot probed for key
+    // Preconditions: allocated()
+    // Postconditions: Returns the first slot of a group of keys
+    uint64_t home(const uint64_t &key) const
+    {
+        const uint64_t slot = (key * 0x9E3779B97F4A7C15ULL >> 17) & mask;
+        return slot & ~(uint64_t)(GROUP - 1);
+    }
+};
+
+#endif /* defined(__EdgeSet__) */
@@ -0,0 +1,274 @@
+//------------------------------------------------------------------------------
+//  Ensemble.cpp
+//------------------------------------------------------------------------------
+// Ensemble censuses a graph and an ensemble of random graphs with its
+// degrees, and compares the class counts. The graph itself is censused with
+// all threads at once; the random graphs are then handed out one at a time
+// from a shared counter, each thread censusing its own on a single-thread
+// Census, since a small random graph is censused faster whole on one thread
+// than shared out among many. Each finished census is folded into the
+// running statistics under a lock, which is cheap next to the census.
+//
+// A class the random graphs have not shown before is given a running count
+// of as many zeros as there were replicates before it, so every class
+// always has exactly one value per replicate.
+//
+// When a run may stop early its replicates are taken in rounds, and the
+// threads are joined after each round so that the check for stopping sees
+// the tallies of exactly the replicates before it.
+//
+// ASSUMPTIONS:
+//   -- As in Ensemble.h
+//
+//------------------------------------------------------------------------------
+
+#include "Ensemble.h"
+#include "Census.h"
+#include "Random.h"
+#include "Randomizer.h"
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+//--------------------------------- Constructor --------------------------------
+// Prepare to judge the size-k subgraphs of graph on threads threads
+// Preconditions: 2 <= k <= Classifier::MAX_SIZE
+// Postconditions: Nothing is counted until run is called
+Ensemble::Ensemble(const Graph &graph, const int &k, const int &threads)
+    : graph(graph), k(k), threads(max(1, threads))
+{}
+
+
+//---------------------------------- setSwaps ----------------------------------
+// Make every random graph with perEdge edge switches per edge
+// Preconditions: perEdge >= 0; tries >= 1
+// Postconditions: Later runs use these values
+void Ensemble::setSwaps(const double &perEdge, const int &tries)
+{
+    swapsPerEdge = perEdge;
+    triesPerSwap = max(1, tries);
+}
+
+//--------------------------------- setStopping --------------------------------
+// Stop a run early once the z-score of every class is pinned down
+// Preconditions: width >= 0; threshold >= 0; every >= 1
+// Postconditions: Later runs use these values
+void Ensemble::setStopping(const double &width, const double &threshold,
+                           const int &every)
+{
+    stopWidth = width;
+    stopThreshold = threshold;
+    stopEvery = max(1, every);
+}
+
+//------------------------------------- run ------------------------------------
+// Census the graph and then up to replicates random graphs
+// Preconditions: replicates >= 0
+// Postconditions: significance() compares the graph with the random graphs
+//                 of this run
+void Ensemble::run(const int &replicates)
+{
+    Census census(graph, k, threads);
+    census.setClassification();
+    census.run();
+    realTotal = census.total();
+    real = census.classCounts();
+    
+    tallies.clear();
+    totals = Moments();
+    done = 0;
+    requested = replicates;
+    for (const pair<const ClassKey, Counter> &entry : real)
+        tallies[entry.first];
+    
+    const int round = stopWidth > 0.0 ? stopEvery : max(1, replicates);
+    while (done < replicates)
+    {
+        const int end = min(replicates, done + round);
+        atomic<int> next(done);
+        vector<thread> workers;
+        for (int t = 1; t < min(threads, end - done); t++)
+            workers.push_back(thread(&Ensemble::sample, this, ref(next),
+                                     end));
+        sample(next, end);
+        for (thread &worker : workers)
+            worker.join();
+    
+        if (stopWidth > 0.0 && settled())
+            break;
+    }
+}
+
+//-------------------------------- significance --------------------------------
+// Significance of every class seen in the graph or a random graph
+// Preconditions: run has been called
+// Postconditions: Returns one entry per class, in decreasing order of count
+//                 in the graph, then of mean count
+vector<Ensemble::Significance> Ensemble::significance() const
+{
+    vector<Significance> result;
+    for (const pair<const ClassKey, Tally> &entry : tallies)
+    {
+        const Tally &tally = entry.second;
+        ClassCounts::const_iterator found = real.find(entry.first);
+    
+        Significance s;
+        s.key = entry.first;
+        s.count = found != real.end() ? found->second : Counter();
+        s.concentration = realTotal != 0
+                          ? s.count.value() / realTotal.value() : 0.0;
+        s.randomConcentration = tally.share.mean;
+        s.randomMean = tally.count.mean;
+        s.randomDeviation = tally.count.deviation();
+        s.zScore = zScore(s.count, tally.count);
+        s.pValue = done > 0 ? (double)tally.above / done : 1.0;
+        result.push_back(s);
+    }
+    
+    sort(result.begin(), result.end(),
+         [](const Significance &a, const Significance &b)
+    {
+        if (a.count.value() != b.count.value())
+            return a.count.value() > b.count.value();
+        if (a.randomMean != b.randomMean)
+            return a.randomMean > b.randomMean;
+        return a.key < b.key;
+    });
+    
+    return result;
+}
+
+//----------------------------------- display ----------------------------------
+// Display the result of the last run
+// Preconditions: run has been called
+// Postconditions: The subgraph totals and one line per class are displayed
+void Ensemble::display() const
+{
+    cout << "Subgraphs = " << realTotal << endl;
+    cout << "Random graphs = " << done;
+    if (done < requested)
+        cout << " of " << requested;
+    cout << ", subgraphs " << totals.mean << " +- " << totals.deviation()
+         << endl;
+    
+    // One line per class: its graph6 label, the count and concentration in
+    // the graph, the mean concentration, mean count and its standard
+    // deviation in the random graphs, the z-score and the p-value
+    const vector<Significance> classes = significance();
+    cout << "Classes = " << classes.size() << endl;
+    for (const Significance &s : classes)
+    {
+        cout << Classifier::graph6(s.key, k) << " " << s.count << " "
+             << 100.0 * s.concentration << "% " << 100.0 * s.randomConcentration
+             << "% " << s.randomMean << " +- " << s.randomDeviation
+             << " z=" << s.zScore << " p=" << s.pValue << endl;
+    }
+}
+
+
+//------------------------------- PRIVATE: sample ------------------------------
+// Body of one thread: census random graphs until replicates are taken
+// (the end of the round)
+// Preconditions: The graph itself has been censused
+// Postconditions: Every replicate taken has been tallied
+void Ensemble::sample(atomic<int> &next, const int &replicates)
+{
+    // Built once and rewired for every replicate
+    Graph replicate(graph);
+    replicate.buildEdgeIndex();
+    Randomizer randomizer(graph);
+    randomizer.setSwaps(swapsPerEdge, triesPerSwap);
+    Census census(replicate, k, 1);
+    census.setClassification();
+    
+    for (int r = next++; r < replicates; r = next++)
+    {
+        randomizer.reset();
+        randomizer.reseed(Random::mix(seed + (uint64_t)r));
+        randomizer.randomize();
+        randomizer.writeTo(replicate);
+        census.run();
+        tally(census.total(), census.classCounts());
+    }
+}
+
+//------------------------------- PRIVATE: tally -------------------------------
+// Fold the census of one random graph into the statistics
+// Preconditions: None
+// Postconditions: done has grown by 1, and every class has one more count
+void Ensemble::tally(const Counter &total, const ClassCounts &counts)
+{
+    lock_guard<mutex> guard(tallyLock);
+    
+    // A class new to the ensemble had a count of 0 in every earlier graph
+    for (const pair<const ClassKey, Counter> &entry : counts)
+        if (tallies.find(entry.first) == tallies.end())
+        {
+            Tally &fresh = tallies[entry.first];
+            fresh.count.n = fresh.share.n = done;
+            if (real.find(entry.first) == real.end())
+                fresh.above = done;
+        }
+    
+    done++;
+    totals.add(total.value());
+    for (pair<const ClassKey, Tally> &entry : tallies)
+    {
+        ClassCounts::const_iterator found = counts.find(entry.first);
+        const Counter count = found != counts.end() ? found->second
+                                                    : Counter();
+        ClassCounts::const_iterator own = real.find(entry.first);
+        const Counter target = own != real.end() ? own->second : Counter();
+    
+        Tally &tally = entry.second;
+        tally.count.add(count.value());
+        tally.share.add(total != 0 ? count.value() / total.value() : 0.0);
+        tally.above += !(count < target);
+    }
+}
+
+//------------------------------ PRIVATE: settled ------------------------------
+// Check whether the z-score of every class is pinned down
+// Preconditions: No thread is tallying
+// Postconditions: Returns true if every interval is narrow or decided
+bool Ensemble::settled() const
+{
+    if (done == 0)
+        return false;
+    
+    for (const pair<const ClassKey, Tally> &entry : tallies)
+    {
+        ClassCounts::const_iterator found = real.find(entry.first);
+        const Counter count = found != real.end() ? found->second : Counter();
+        const double z = zScore(count, entry.second.count);
+        if (isinf(z))
+            continue;
+    
+        // Half the 95% interval, from the standard error of the z-score
+        const double half = 1.96 * sqrt((1.0 + z * z / 2.0) / done);
+        const bool narrow = 2.0 * half < stopWidth;
+        const bool decided = fabs(z) - half > stopThreshold ||
+                             fabs(z) + half < stopThreshold;
+        if (!narrow && !decided)
+            return false;
+    }
+    
+    return true;
+}
+
+//------------------------------- PRIVATE: zScore ------------------------------
+// z-score of count against the random counts in moments
+// Preconditions: None
+// Postconditions: A deviation of 0 gives 0 if count equals the mean and
+//                 plus or minus infinity otherwise
+double Ensemble::zScore(const Counter &count, const Moments &moments)
+{
+    const double excess = count.value() - moments.mean;
+    const double deviation = moments.deviation();
+    if (deviation > 0.0)
+        return excess / deviation;
+    if (excess == 0.0)
+        return 0.0;
+    return excess > 0.0 ? numeric_limits<double>::infinity()
+                        : -numeric_limits<double>::infinity();
+}
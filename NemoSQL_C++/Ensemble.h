@@ -0,0 +1,220 @@
+//------------------------------------------------------------------------------
+//  Ensemble.h
+//------------------------------------------------------------------------------
+// Ensemble judges the isomorphism classes of the size-k subgraphs of a graph
+// against random graphs with the same degrees, the core of motif detection.
+// It runs a classifying Census of the graph itself on every thread, then
+// generates the random graphs with a Randomizer and censuses them, one
+// random graph per thread at a time. A class whose count in the graph is far
+// above its counts in the random graphs is a motif.
+//
+// Every thread keeps one random graph, one Randomizer and one single-thread
+// Census for a whole round of replicates, and only rewires the graph between
+// replicates. The Census keeps its ESUEngine and per-root arrays from run to
+// run, so the buffers are allocated once per thread and round rather than
+// once per replicate.
+// Replicate r always starts from the graph itself and draws its switches
+// from a generator seeded from the seed and r, so the ensemble does not
+// depend on the number of threads. The count of every class in each random
+// graph is folded into a running mean and variance (Welford's method) as
+// soon as its census ends, so no per-replicate result is kept.
+//
+// For every class the ensemble reports the count and concentration (share of
+// all subgraphs) in the graph, the mean concentration and the mean and
+// standard deviation of the count over the random graphs, the z-score of
+// the count, and the empirical p-value: the fraction of random graphs in
+// which the class is at least as frequent as in the graph.
+//
+// A run may stop before all its replicates once they have pinned down every
+// z-score (see setStopping). Its replicates are then censused in rounds, and
+// after each round the 95% confidence interval of every z-score is taken
+// from the standard error of the z-score of a normal sample, which is
+// sqrt((1 + z^2 / 2) / n) for n replicates. The run stops once every
+// interval is narrower than the width asked for or lies wholly on one side
+// of the significance threshold, so that more replicates could neither
+// sharpen the z-score much nor change which classes are significant. A
+// class with a random deviation of 0 and an infinite z-score counts as
+// pinned down. Rounds are a fixed number of replicates and the check only
+// runs between them, so where a run stops does not depend on the threads.
+//
+// ASSUMPTIONS:
+//   -- The Graph is simple and is not modified while an ensemble runs
+//   -- 2 <= k <= Classifier::MAX_SIZE
+//
+//------------------------------------------------------------------------------
+
+#ifndef __Ensemble__
+#define __Ensemble__
+
+#include "Classifier.h"
+#include "Counter.h"
+#include "Graph.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+class Ensemble
+{
+public:
+    
+    // Significance of one class of the graph against the random graphs
+    struct Significance
+    {
+        ClassKey key;                       // the class
+        Counter count;                      // its subgraphs in the graph
+        double concentration;               // their share of all subgraphs
+        double randomConcentration;         // mean share in random graphs
+        double randomMean;                  // mean count in random graphs
+        double randomDeviation;             // standard deviation of that
+        double zScore;                      // (count - mean) / deviation
+        double pValue;                      // share with count >= count
+    };
+    
+    //------------------------------- Constructor ------------------------------
+    // Prepare to judge the size-k subgraphs of graph on threads threads
+    // Preconditions: 2 <= k <= Classifier::MAX_SIZE
+    // Postconditions: Nothing is counted until run is called. A threads value
+    //                 below 1 means one thread.
+    Ensemble(const Graph &graph, const int &k, const int &threads = 1);
+    
+    
+    //-------------------------------- setSwaps --------------------------------
+    // Make every random graph with perEdge edge switches per edge, giving up
+    // after tries attempts per switch (see Randomizer::setSwaps)
+    // Preconditions: perEdge >= 0; tries >= 1
+    // Postconditions: The default is 3 switches per edge and 3 tries
+    void setSwaps(const double &perEdge, const int &tries = 3);
+    
+    //--------------------------------- setSeed --------------------------------
+    // Seed the generators of the random graphs
+    // Preconditions: None
+    // Postconditions: Replicate r draws from a generator derived from seed
+    //                 and r; the default seed is 1
+    void setSeed(const uint64_t &seed) { this->seed = seed; }
+    
+    //------------------------------- setStopping ------------------------------
+    // Stop a run early, after a round of every replicates, once the 95%
+    // confidence interval of the z-score of every class is narrower than
+    // width or excludes both threshold and -threshold
+    // Preconditions: width >= 0; threshold >= 0; every >= 1
+    // Postconditions: A width of 0, the default, runs every replicate
+    void setStopping(const double &width, const double &threshold = 2.0,
+                     const int &every = 25);
+    
+    //----------------------------------- run ----------------------------------
+    // Census the graph and then up to replicates random graphs
+    // Preconditions: replicates >= 0
+    // Postconditions: significance() compares the graph with the random
+    //                 graphs of this run, which are all replicates unless
+    //                 setStopping stopped the run early
+    void run(const int &replicates);
+    
+    //------------------------------- replicates -------------------------------
+    // Number of random graphs censused by the last run
+    // Preconditions: None
+    // Postconditions: Returns the replicates given to run, or fewer if the
+    //                 run stopped early
+    int replicates() const { return done; }
+    
+    //------------------------------- significance -----------------------------
+    // Significance of every class seen in the graph or a random graph
+    // Preconditions: run has been called
+    // Postconditions: Returns one entry per class, in decreasing order of
+    //                 count in the graph, then of mean count. A deviation
+    //                 of 0 gives a z-score of 0 if the count equals the mean
+    //                 and of plus or minus infinity otherwise.
+    vector<Significance> significance() const;
+    
+    //--------------------------------- display --------------------------------
+    // Display the result of the last run
+    // Preconditions: run has been called
+    // Postconditions: The subgraph totals and one line per class, with the
+    //                 figures of significance(), are displayed
+    void display() const;
+    
+    
+private:
+    
+    // Running mean and sum of squared deviations (Welford's method)
+    struct Moments
+    {
+        long n = 0;                         // values added
+        double mean = 0.0;                  // their mean
+        double squares = 0.0;               // sum of squared deviations
+    
+        void add(const double &x)
+        {
+            n++;
+            const double delta = x - mean;
+            mean += delta / n;
+            squares += delta * (x - mean);
+        }
+    
+        double deviation() const
+        {
+            return n > 1 ? sqrt(squares / (n - 1)) : 0.0;
+        }
+    };
+    
+    // Random graph statistics of one class
+    struct Tally
+    {
+        Moments count;                      // subgraphs of the class
+        Moments share;                      // concentration of the class
+        long above = 0;                     // graphs with count >= real count
+    };
+    
+    const Graph &graph;                     // graph being judged
+    const int k;                            // subgraph size
+    const int threads;                      // census and replicate threads
+    double swapsPerEdge = 3.0;              // see setSwaps
+    int triesPerSwap = 3;                   // see setSwaps
+    uint64_t seed = 1;                      // see setSeed
+    double stopWidth = 0.0;                 // see setStopping
+    double stopThreshold = 2.0;             // see setStopping
+    int stopEvery = 25;                     // see setStopping
+    
+    Counter realTotal;                      // subgraphs of the graph
+    ClassCounts real;                       // and by class
+    
+    mutex tallyLock;                        // guards the fields below
+    unordered_map<ClassKey, Tally, ClassKeyHash> tallies;
+    Moments totals;                         // subgraphs of the random graphs
+    int done = 0;                           // random graphs tallied
+    int requested = 0;                      // replicates given to run
+    
+    
+    //---------------------------- PRIVATE: sample -----------------------------
+    // Body of one thread: take replicate numbers from next and census their
+    // random graphs until replicates are taken
+    // Preconditions: The graph itself has been censused
+    // Postconditions: Every replicate taken has been tallied
+    void sample(atomic<int> &next, const int &replicates);
+    
+    //---------------------------- PRIVATE: tally ------------------------------
+    // Fold the census of one random graph into the statistics
+    // Preconditions: None
+    // Postconditions: done has grown by 1, and every class has one more
+    //                 count, 0 for the classes the graph lacks
+    void tally(const Counter &total, const ClassCounts &counts);
+    
+    //--------------------------- PRIVATE: settled -----------------------------
+    // Check whether the z-score of every class is pinned down
+    // Preconditions: No thread is tallying
+    // Postconditions: Returns true if every z-score is infinite or has a
+    //                 confidence interval narrow enough for setStopping
+    bool settled() const;
+    
+    //--------------------------- PRIVATE: zScore ------------------------------
+    // z-score of count against the random counts in moments
+    // Preconditions: None
+    // Postconditions: See significance()
+    static double zScore(const Counter &count, const Moments &moments);
+};
+
+#endif /* defined(__Ensemble__) */
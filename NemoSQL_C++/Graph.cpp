@@ -2,8 +2,11 @@
 //  Graph.cpp
 //  Created by Kunlakan Cherdchusilp, Ngoc Luu, Jonathan Earl, and Alan Nyugen
 //------------------------------------------------------------------------------
-// Graph is an undirected and unweigthed graph that is represented by adjacency
-// list of vertices that are connected to each other.
+// Graph is an undirected and unweigthed graph that is represented by an
+// immutable compressed sparse row (CSR) adjacency: the neighbors of vertex v
+// are stored sorted in neighbors[offsets[v]] .. neighbors[offsets[v + 1] - 1].
+// Input vertex IDs are compacted to 0 .. n-1 when the graph is built, and
+// originalId maps a vertex back to the ID it was read with.
 // features are included:
 //   -- allows adding and removing edges
 //   -- allows displaying of the whole Graph with distance and path
@@ -19,6 +22,82 @@
 
 
 #include "Graph.h"
+#include "MappedFile.h"
+#include "Census.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+const uint32_t Graph::SNAPSHOT_VERSION;
+const size_t Graph::MAX_BIT_MATRIX_BYTES;
+
+// Files smaller than this many bytes per thread are parsed by fewer threads
+static const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+//-------------------------------- parallelFor ---------------------------------
+// Run body(0) .. body(count - 1) concurrently
+// Preconditions: None
+// Postconditions: Every body call has returned. body(0) runs on the calling
+//                 thread, so a count of 1 spawns no thread at all.
+static void parallelFor(const int &count, const function<void(int)> &body)
+{
+    vector<thread> workers;
+    for (int t = 1; t < count; t++)
+        workers.push_back(thread(body, t));
+    
+    if (count > 0)
+        body(0);
+    
+    for (thread &worker : workers)
+        worker.join();
+}
+
+//--------------------------------- blockBegin ---------------------------------
+// First vertex of block t when n vertices are split into blocks equal blocks
+// Preconditions: 0 <= t <= blocks
+// Postconditions: Returns n * t / blocks without overflowing
+static inline int blockBegin(const int &t, const int &n, const int &blocks)
+{
+    return (int)((long)n * t / blocks);
+}
+
+//---------------------------------- scanInt -----------------------------------
+// Scan the next decimal integer in [p, end)
+// Preconditions: None
+// Postconditions: Returns the position just past the integer and stores it in
+//                 value, or returns end with value -1 if only separators
+//                 remain. Any byte that is not a digit is treated as a
+//                 separator, except a minus sign just before a digit. A
+//                 negative integer, or one above INT_MAX, stores BAD_INT.
+static const int BAD_INT = -2;
+
+static inline const char *scanInt(const char *p, const char *end, int &value)
+{
+    const char *from = p;
+    while (p != end && (unsigned char)(*p - '0') > 9)
+        p++;
+    
+    const bool negative = p != from && p[-1] == '-';
+    uint64_t v = 0;
+    const char *digits = p;
+    while (p != end && (unsigned char)(*p - '0') <= 9)
+    {
+        // Saturate rather than wrap, the value is rejected anyway
+        if (v <= (uint64_t)INT_MAX)
+            v = v * 10 + (uint64_t)(*p - '0');
+        p++;
+    }
+    
+    if (p == digits)
+        value = -1;
+    else if (negative || v > (uint64_t)INT_MAX)
+        value = BAD_INT;
+    else
+        value = (int)v;
+    return p;
+}
 
 //--------------------------- A Default Constructor ----------------------------
 // Default constructor for class Graph
@@ -33,153 +112,688 @@ Graph::Graph(){}
 Graph::~Graph()
 {}
 
+//------------------------------ Copy Constructor ------------------------------
+// Copy constructor and assignment for class Graph
+// Preconditions: None
+// Postconditions: This graph has the same adjacency as other. A graph
+//                 backed by a snapshot shares the read-only mapping.
+Graph::Graph(const Graph &other)
+{
+    *this = other;
+}
+
+Graph &Graph::operator=(const Graph &other)
+{
+    if (this == &other)
+        return *this;
+    
+    offsets = other.offsets;
+    neighbors = other.neighbors;
+    ids = other.ids;
+    bindOwned();
+    
+    edgeBits = other.edgeBits;
+    bitRowWords = other.bitRowWords;
+    edgeHash = other.edgeHash;
+    
+    if (other.snapshot)
+    {
+        snapshot = other.snapshot;
+        n = other.n;
+        rowOffsets = other.rowOffsets;
+        rowNeighbors = other.rowNeighbors;
+        vertexIds = other.vertexIds;
+    }
+    
+    return *this;
+}
+
+//------------------------------ PRIVATE: bindOwned ----------------------------
+// Point the CSR views at the owned vectors
+// Preconditions: offsets, neighbors and ids describe a complete graph
+// Postconditions: Any snapshot mapping and any edge index are released
+void Graph::bindOwned()
+{
+    snapshot.reset();
+    edgeBits.clear();
+    edgeBits.shrink_to_fit();
+    bitRowWords = 0;
+    edgeHash.release();
+    n = (int)offsets.size() - 1;
+    rowOffsets = offsets.data();
+    rowNeighbors = neighbors.data();
+    vertexIds = ids.data();
+}
+
 
 //--------------------------------- buildGraph ---------------------------------
 // Builds a graph by reading data from an ifstream
 // Preconditions:  infile has been successfully opened and the file contains
 //                 properly formated data (according to the program specs)
-// Postconditions: A graph is read from infile and stored in the object
-void Graph::buildGraph(ifstream& infile)
+// Postconditions: Returns false, leaving the graph unchanged, if infile holds
+//                 a negative vertex ID or one above INT_MAX. Otherwise a
+//                 graph is read from infile and stored in the object
+bool Graph::buildGraph(ifstream& infile)
 {
-    int src = -1, dest = -1;
+    vector<pair<int, int>> edges;
+    long long src = -1, dest = -1;
     
     infile >> src >> dest;
     
     while (infile)
     {
+        if (src < 0 || dest < 0 || src > INT_MAX || dest > INT_MAX)
+            return false;
         if(src != dest)
-        {
-            exist(src);
-            exist(dest);
-            
-            vertices[src].insert(dest);
-            vertices[dest].insert(src);
-        }
+            edges.push_back(make_pair((int)src, (int)dest));
         
         infile >> src >> dest;
     }
+    
+    vector<vector<pair<int, int>>> buffers(1);
+    buffers[0].swap(edges);
+    buildCSR(buffers, 1);
+    return true;
 }
 
-//------------------------------- PRIVATE: exist -------------------------------
-// Check if vertex already exists in the vector vertices
-// Preconditions: None
-// Postconditions: If vertex already exists in the vector vertices, then do
-//                 nothing. Otherwise, add vertex to the vector vertices.
-void Graph::exist(const int &vertex){
-    if(vertex < vertices.size())
-        return;
+//--------------------------------- buildGraph ---------------------------------
+// Builds a graph by memory mapping filename and scanning the "src dest"
+// pairs in place. The mapping is cut into up to threads byte ranges aligned
+// to line boundaries, and every range is parsed on its own thread into its own
+// edge buffer. Each range is scanned twice, once to count its edges and once
+// to fill an exactly sized buffer, so nothing is reallocated.
+// Preconditions:  The file contains properly formated data (according to
+//                 the program specs)
+// Postconditions: Returns false, leaving the graph unchanged, if the file
+//                 could not be mapped or holds a negative vertex ID or one
+//                 above INT_MAX. Otherwise a graph is read from filename and
+//                 stored in the object
+bool Graph::buildGraph(const string &filename, const int &threads)
+{
+    MappedFile file;
+    if (!file.open(filename))
+        return false;
+    
+    const char *begin = file.data();
+    const char *end = begin + file.size();
+    
+    // Small files are not worth a thread per range
+    size_t chunks = max<size_t>(1, file.size() / MIN_CHUNK_BYTES);
+    chunks = min(chunks, (size_t)max(1, threads));
     
-    for(long i = vertices.size(); i <= vertex; i++)
-        vertices.push_back(*new unordered_set<int>);
+    vector<const char *> cuts(chunks + 1, end);
+    cuts[0] = begin;
+    for (size_t c = 1; c < chunks; c++)
+    {
+        const char *p = max(begin + file.size() / chunks * c, cuts[c - 1]);
+        while (p != end && *p != '\n')
+            p++;
+        cuts[c] = (p == end) ? end : p + 1;
+    }
     
-    vertices[vertex] = *new unordered_set<int>;
+    vector<vector<pair<int, int>>> buffers(chunks);
+    vector<char> valid(chunks);
+    parallelFor((int)chunks, [&](int t)
+    {
+        valid[t] = scanEdges(cuts[t], cuts[t + 1], buffers[t]);
+    });
+    if (find(valid.begin(), valid.end(), 0) != valid.end())
+        return false;
+    
+    buildCSR(buffers, (int)chunks);
+    return true;
 }
 
+//------------------------------ PRIVATE: scanEdges ----------------------------
+// Parse the "src dest" pairs of a line-aligned byte range
+// Preconditions: [begin, end) starts at a line boundary and ends at a line
+//                boundary or at the end of the file
+// Postconditions: Returns false if the range holds an ID that scanInt
+//                 rejects. Otherwise edges holds every complete pair of the
+//                 range in file order.
+bool Graph::scanEdges(const char *begin, const char *end,
+                      vector<pair<int, int>> &edges)
+{
+    int src = -1, dest = -1;
+    
+    // Pass 1: count the complete pairs and check every ID
+    size_t pairs = 0;
+    for (const char *p = begin; ; pairs++)
+    {
+        p = scanInt(p, end, src);
+        p = scanInt(p, end, dest);
+        if (src == BAD_INT || dest == BAD_INT)
+            return false;
+        if (dest < 0)
+            break;
+    }
+    
+    // Pass 2: fill the exactly sized edge list
+    edges.resize(pairs);
+    const char *p = begin;
+    for (size_t i = 0; i < pairs; i++)
+    {
+        p = scanInt(p, end, src);
+        p = scanInt(p, end, dest);
+        edges[i] = make_pair(src, dest);
+    }
+    
+    return true;
+}
 
-//---------------------------------- display -----------------------------------
-// Display a all detailed path
-// Preconditions: vertices[vertexFrom] and its data must exist
-// Postconditions: all detailed path is displayed
-void Graph::display() const
+//------------------------------ PRIVATE: buildCSR -----------------------------
+// Build the CSR adjacency from buffers of undirected edges with a parallel
+// counting sort: the input IDs are first compacted to 0 .. n-1, then every
+// buffer counts its contributions to every row, the counts are turned into
+// disjoint write cursors, and the buffers are scattered, sorted and
+// deduplicated concurrently
+// Preconditions: Every endpoint in buffers is non-negative
+// Postconditions: Only vertices with at least one edge other than a self
+//                 loop are kept, numbered in increasing order of input ID,
+//                 and ids maps them back. offsets and neighbors hold every
+//                 edge in both directions with self loops and duplicate edges
+//                 removed, and every adjacency row sorted in increasing
+//                 order. The endpoints in buffers are rewritten to the
+//                 compacted IDs.
+void Graph::buildCSR(vector<vector<pair<int, int>>> &buffers,
+                     const int &threads)
 {
-    cout << "From\t\t";
-    cout << "To" << endl;
+    const int T = max(1, threads);
+    const int B = (int)buffers.size();
+    
+    vector<int> maxima(B, -1);
+    parallelFor(B, [&](int b)
+    {
+        for (const pair<int, int> &e : buffers[b])
+            maxima[b] = max(maxima[b], max(e.first, e.second));
+    });
+    const int maxId = *max_element(maxima.begin(), maxima.end());
+    
+    size_t endpoints = 0;
+    for (const vector<pair<int, int>> &buffer : buffers)
+        endpoints += 2 * buffer.size();
     
-    for(int i = 0; i < vertices.size(); i++)
+    // Collect the IDs in use in increasing order. IDs that are dense enough
+    // are marked in a direct table; very sparse IDs are sorted instead.
+    vector<int> table;
+    ids.clear();
+    if ((size_t)maxId < 8 * endpoints + 1024)
     {
-        if (vertices[i].size() > 0)
+        table.assign(maxId + 1, -1);
+        for (const vector<pair<int, int>> &buffer : buffers)
+            for (const pair<int, int> &e : buffer)
+                if (e.first != e.second)
+                    table[e.first] = table[e.second] = 0;
+        
+        for (int id = 0; id <= maxId; id++)
+            if (table[id] == 0)
+            {
+                table[id] = (int)ids.size();
+                ids.push_back(id);
+            }
+    }
+    else
+    {
+        ids.reserve(endpoints);
+        for (const vector<pair<int, int>> &buffer : buffers)
+            for (const pair<int, int> &e : buffer)
+                if (e.first != e.second)
+                {
+                    ids.push_back(e.first);
+                    ids.push_back(e.second);
+                }
+        
+        sort(ids.begin(), ids.end());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+        ids.shrink_to_fit();
+    }
+    const int n = (int)ids.size();
+    
+    parallelFor(B, [&](int b)
+    {
+        for (pair<int, int> &e : buffers[b])
         {
-            cout << i << ": ";
-            
-            for (int vertice : vertices[i])
-                cout << vertice << " ";
-            
-            cout << endl;
+            if (e.first == e.second)
+                e = make_pair(-1, -1);
+            else if (!table.empty())
+                e = make_pair(table[e.first], table[e.second]);
+            else
+                e = make_pair(
+                    (int)(lower_bound(ids.begin(), ids.end(), e.first) -
+                          ids.begin()),
+                    (int)(lower_bound(ids.begin(), ids.end(), e.second) -
+                          ids.begin()));
+        }
+    });
+    table.clear();
+    table.shrink_to_fit();
+    
+    // cursor[b][v] first counts how many slots buffer b needs in row v
+    vector<vector<int>> cursor(B);
+    parallelFor(B, [&](int b)
+    {
+        cursor[b].assign(n, 0);
+        for (const pair<int, int> &e : buffers[b])
+        {
+            if (e.first == e.second)
+                continue;
+            cursor[b][e.first]++;
+            cursor[b][e.second]++;
+        }
+    });
+    
+    // Prefix sum over (row, buffer) in T vertex blocks: block totals first,
+    // then every block turns its counts into absolute write cursors
+    vector<int> start(n + 1, 0);
+    vector<long> blockStart(T + 1, 0);
+    parallelFor(T, [&](int t)
+    {
+        long total = 0;
+        for (int v = blockBegin(t, n, T); v < blockBegin(t + 1, n, T); v++)
+            for (int b = 0; b < B; b++)
+                total += cursor[b][v];
+        blockStart[t + 1] = total;
+    });
+    for (int t = 0; t < T; t++)
+        blockStart[t + 1] += blockStart[t];
+    
+    parallelFor(T, [&](int t)
+    {
+        int position = (int)blockStart[t];
+        for (int v = blockBegin(t, n, T); v < blockBegin(t + 1, n, T); v++)
+        {
+            start[v] = position;
+            for (int b = 0; b < B; b++)
+            {
+                int slots = cursor[b][v];
+                cursor[b][v] = position;
+                position += slots;
+            }
+        }
+    });
+    start[n] = (int)blockStart[T];
+    
+    vector<int> adjacency(start[n]);
+    parallelFor(B, [&](int b)
+    {
+        vector<int> &fill = cursor[b];
+        for (const pair<int, int> &e : buffers[b])
+        {
+            if (e.first == e.second)
+                continue;
+            adjacency[fill[e.first]++] = e.second;
+            adjacency[fill[e.second]++] = e.first;
+        }
+    });
+    cursor.clear();
+    
+    // Sort every row and drop duplicates, then pack the rows with a second
+    // blocked prefix sum
+    vector<int> rowSize(n);
+    parallelFor(T, [&](int t)
+    {
+        long total = 0;
+        for (int v = blockBegin(t, n, T); v < blockBegin(t + 1, n, T); v++)
+        {
+            int *first = adjacency.data() + start[v];
+            int *last = adjacency.data() + start[v + 1];
+            sort(first, last);
+            rowSize[v] = (int)(unique(first, last) - first);
+            total += rowSize[v];
+        }
+        blockStart[t + 1] = total;
+    });
+    for (int t = 0; t < T; t++)
+        blockStart[t + 1] += blockStart[t];
+    
+    offsets.assign(n + 1, 0);
+    neighbors.assign(blockStart[T], 0);
+    parallelFor(T, [&](int t)
+    {
+        int position = (int)blockStart[t];
+        for (int v = blockBegin(t, n, T); v < blockBegin(t + 1, n, T); v++)
+        {
+            offsets[v] = position;
+            copy(adjacency.data() + start[v],
+                 adjacency.data() + start[v] + rowSize[v],
+                 neighbors.data() + position);
+            position += rowSize[v];
         }
+    });
+    offsets[n] = (int)blockStart[T];
+    
+    bindOwned();
+}
+
+//-------------------------------- writeSnapshot -------------------------------
+// Write the graph in the binary snapshot format: a SnapshotHeader followed
+// by the CSR offsets, the CSR neighbors and the original vertex IDs, each
+// section starting on an 8-byte boundary. The header records the size and
+// modification time of source, so a later load can tell a stale snapshot.
+// The file is written under a temporary name and renamed into place, so a
+// crash never leaves a partial snapshot under filename.
+// Preconditions:  None
+// Postconditions: Returns false if filename could not be written or source,
+//                 if given, could not be examined
+bool Graph::writeSnapshot(const string &filename, const string &source) const
+{
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    if (!source.empty() &&
+        !MappedFile::fileStamp(source, header.sourceSize,
+                               header.sourceModified))
+        return false;
+    
+    const string temporary = filename + ".tmp";
+    ofstream outfile(temporary.c_str(), ios::binary | ios::trunc);
+    if (!outfile)
+        return false;
+    
+    const uint64_t m = (uint64_t)rowOffsets[n];
+    auto align = [](uint64_t at) { return (at + 7) & ~(uint64_t)7; };
+    
+    memcpy(header.magic, "NEMOCSR", 8);
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = 0x01020304;
+    header.vertexCount = (uint64_t)n;
+    header.neighborCount = m;
+    header.offsetsAt = align(sizeof(header));
+    header.neighborsAt = align(header.offsetsAt + (n + 1) * sizeof(int));
+    header.idsAt = align(header.neighborsAt + m * sizeof(int));
+    
+    // Sections are written in file order, zero padding up to each start
+    const char padding[8] = {0};
+    auto section = [&](uint64_t at, const int *data, uint64_t count)
+    {
+        outfile.write(padding, (streamsize)(at - (uint64_t)outfile.tellp()));
+        outfile.write(reinterpret_cast<const char *>(data),
+                      (streamsize)(count * sizeof(int)));
+    };
+    
+    outfile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    section(header.offsetsAt, rowOffsets, (uint64_t)n + 1);
+    section(header.neighborsAt, rowNeighbors, m);
+    section(header.idsAt, vertexIds, (uint64_t)n);
+    outfile.close();
+    
+    if (!outfile || rename(temporary.c_str(), filename.c_str()) != 0)
+    {
+        remove(temporary.c_str());
+        return false;
     }
+    return true;
 }
 
-//------------------------------ enumerateSubgraph -----------------------------
-// Enumerate size-k subgraphs of the original graph
-// Preconditions: The graph should have already been built or exists
-// Postcondition: The list of subgraphs are displayed
-void Graph::enumerateSubgraph(const int &k)
+//-------------------------------- loadSnapshot --------------------------------
+// Map a file written by writeSnapshot and use its sections in place, with
+// no parsing and no copy of the adjacency. The rows are checked in one
+// linear pass, so a corrupt file is rejected instead of read out of bounds.
+// Preconditions:  None
+// Postconditions: Returns false, leaving the graph unchanged, if filename
+//                 could not be mapped, is not a valid snapshot of this
+//                 version, or was written from a source other than the
+//                 current source (when source is given). Otherwise the graph
+//                 reads the mapped file.
+bool Graph::loadSnapshot(const string &filename, const string &source)
+{
+    shared_ptr<MappedFile> file = make_shared<MappedFile>();
+    if (!file->open(filename) || file->size() < sizeof(SnapshotHeader))
+        return false;
+    
+    SnapshotHeader header;
+    memcpy(&header, file->data(), sizeof(header));
+    if (memcmp(header.magic, "NEMOCSR", 8) != 0 ||
+        header.version != SNAPSHOT_VERSION || header.byteOrder != 0x01020304)
+        return false;
+    
+    // A snapshot of an edited source describes another graph
+    uint64_t sourceSize = 0, sourceModified = 0;
+    if (!source.empty() &&
+        (!MappedFile::fileStamp(source, sourceSize, sourceModified) ||
+         sourceSize != header.sourceSize ||
+         sourceModified != header.sourceModified))
+        return false;
+    
+    // Every section must be aligned and lie inside the file
+    const uint64_t size = file->size();
+    auto fits = [&](uint64_t at, uint64_t count)
+    {
+        return at % sizeof(int) == 0 && at <= size &&
+               count <= (size - at) / sizeof(int);
+    };
+    if (header.vertexCount >= (uint64_t)INT_MAX ||
+        header.neighborCount > (uint64_t)INT_MAX ||
+        !fits(header.offsetsAt, header.vertexCount + 1) ||
+        !fits(header.neighborsAt, header.neighborCount) ||
+        !fits(header.idsAt, header.vertexCount))
+        return false;
+    
+    // The rows must tile the neighbor section and name only real vertices
+    const int vertices = (int)header.vertexCount;
+    const int *mappedOffsets =
+        reinterpret_cast<const int *>(file->data() + header.offsetsAt);
+    const int *mappedNeighbors =
+        reinterpret_cast<const int *>(file->data() + header.neighborsAt);
+    if (mappedOffsets[0] != 0 ||
+        (uint64_t)mappedOffsets[vertices] != header.neighborCount)
+        return false;
+    for (int v = 0; v < vertices; v++)
+        if (mappedOffsets[v + 1] < mappedOffsets[v])
+            return false;
+    for (uint64_t i = 0; i < header.neighborCount; i++)
+        if ((unsigned int)mappedNeighbors[i] >= (unsigned int)vertices)
+            return false;
+    
+    offsets.assign(1, 0);
+    neighbors.clear();
+    ids.clear();
+    bindOwned();
+    
+    n = vertices;
+    rowOffsets = mappedOffsets;
+    rowNeighbors = mappedNeighbors;
+    vertexIds = reinterpret_cast<const int *>(file->data() + header.idsAt);
+    snapshot = file;
+    
+    return true;
+}
+
+
+//----------------------------------- relabel ----------------------------------
+// Renumber the vertices in the given order
+// Preconditions:  None
+// Postconditions: The graph is isomorphic to before, originalId still maps
+//                 every vertex to its input ID and every adjacency row is
+//                 sorted. DEGREE_ORDER numbers vertices by increasing degree
+//                 (ties by current ID), so hubs get the largest IDs and root
+//                 few ESU trees. BFS_ORDER numbers every connected component
+//                 breadth first from its lowest-degree vertex, so neighbors
+//                 get nearby IDs. NATURAL_ORDER returns to increasing input
+//                 ID order. A snapshot-backed graph is copied into memory.
+void Graph::relabel(const VertexOrder &order)
 {
-    count = 0;
+    // byRank[r] is the vertex that receives the new ID r
+    vector<int> byRank(n);
+    for (int v = 0; v < n; v++)
+        byRank[v] = v;
     
-    for(int i = 0; i <= vertices.size(); i++)
+    if (order == NATURAL_ORDER)
     {
-        if(vertices[i].size() > 0)
+        sort(byRank.begin(), byRank.end(), [&](int a, int b)
+             { return vertexIds[a] < vertexIds[b]; });
+    }
+    else if (order == DEGREE_ORDER)
+    {
+        stable_sort(byRank.begin(), byRank.end(), [&](int a, int b)
+                    { return degree(a) < degree(b); });
+    }
+    else if (order == BFS_ORDER)
+    {
+        vector<int> seeds(byRank);
+        stable_sort(seeds.begin(), seeds.end(), [&](int a, int b)
+                    { return degree(a) < degree(b); });
+        
+        vector<bool> placed(n, false);
+        int head = 0, tail = 0;
+        for (int seed : seeds)
         {
-            list<int> Vsubgraph;
-            Vsubgraph.push_back(i);
-            
-            unordered_set<int> visited;
-            visited.insert(i);
+            if (placed[seed])
+                continue;
             
-            unordered_set<int> Vextension;
-            getExtension(Vextension, i);
-            
-            extendSubgraph(Vsubgraph, Vextension, visited, i, k);
+            placed[seed] = true;
+            byRank[tail++] = seed;
+            while (head < tail)
+            {
+                int v = byRank[head++];
+                for (const int *p = neighborBegin(v); p != neighborEnd(v); p++)
+                    if (!placed[*p])
+                    {
+                        placed[*p] = true;
+                        byRank[tail++] = *p;
+                    }
+            }
         }
     }
-    cerr << count << endl;
+    
+    vector<int> rank(n);
+    for (int r = 0; r < n; r++)
+        rank[byRank[r]] = r;
+    
+    vector<int> newOffsets(n + 1, 0);
+    vector<int> newNeighbors(rowOffsets[n]);
+    vector<int> newIds(n);
+    for (int r = 0; r < n; r++)
+    {
+        int v = byRank[r];
+        int *row = newNeighbors.data() + newOffsets[r];
+        int size = 0;
+        for (const int *p = neighborBegin(v); p != neighborEnd(v); p++)
+            row[size++] = rank[*p];
+        sort(row, row + size);
+        
+        newOffsets[r + 1] = newOffsets[r] + size;
+        newIds[r] = vertexIds[v];
+    }
+    
+    offsets.swap(newOffsets);
+    neighbors.swap(newNeighbors);
+    ids.swap(newIds);
+    bindOwned();
 }
 
-//--------------------------- PRIVATE: getExtension ----------------------------
-// Add all neighbors of vertex to Vextension
-// Precondition: Vextension must be decalired and intialized before calling
-//               this function.
-// Postcondition: All neighbors of vertex are added to Vextension
-void Graph::getExtension(unordered_set<int> &Vextension, const int &vertex)
+//----------------------------------- rewire -----------------------------------
+// Replace the edges by edges, keeping the vertices and their degrees
+// Preconditions:  edges is a simple graph on 0 .. vertexCount()-1 in which
+//                 every vertex has its current degree
+// Postconditions: The graph holds exactly edges, with every adjacency row
+//                 sorted and originalId unchanged. An edge index, if built,
+//                 is rebuilt; a snapshot-backed graph is copied into memory.
+void Graph::rewire(const vector<pair<int, int>> &edges)
 {
-    for (int i : vertices[vertex])
+    const bool indexed = bitRowWords > 0 || edgeHash.allocated();
+    if (snapshot)
+    {
+        offsets.assign(rowOffsets, rowOffsets + n + 1);
+        neighbors.resize(offsets[n]);
+        ids.assign(vertexIds, vertexIds + n);
+        bindOwned();
+    }
+    
+    // The degrees, and so the row offsets, stay as they are
+    vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (const pair<int, int> &e : edges)
     {
-        if (i > vertex)
-            Vextension.insert(i);
+        neighbors[fill[e.first]++] = e.second;
+        neighbors[fill[e.second]++] = e.first;
     }
+    for (int v = 0; v < n; v++)
+        sort(neighbors.data() + offsets[v], neighbors.data() + offsets[v + 1]);
+    
+    if (indexed)
+        buildEdgeIndex();
 }
 
-
-//--------------------------- PRIVATE: extendSubgraph --------------------------
-// Recursively looking size-k subgraphs of the graph.
-// Precondition: The graph should have already been built or exists
-// Postcondition: The list of subgraphs are displayed
-void Graph::extendSubgraph(list<int> &Vsubgraph, unordered_set<int> &Vextension, unordered_set<int> &visited, const int &v, const int &k)
+//-------------------------------- buildEdgeIndex ------------------------------
+// Build the secondary edge index used by hasEdge: a dense n-by-n bit
+// matrix when it fits in MAX_BIT_MATRIX_BYTES, otherwise an open-addressed
+// hash set of the edges probed four slots at a time
+// Preconditions:  None
+// Postconditions: hasEdge answers in constant time until the graph is
+//                 rebuilt, relabeled or reloaded
+void Graph::buildEdgeIndex()
 {
-    if(Vsubgraph.size() == k-1)
+    const size_t words = ((size_t)n + 63) / 64;
+    
+    if (words * n * sizeof(uint64_t) <= MAX_BIT_MATRIX_BYTES)
     {
-        for(int w : Vextension)
-            count++;
+        edgeHash.release();
         
+        edgeBits.assign(words * n, 0);
+        for (int u = 0; u < n; u++)
+        {
+            uint64_t *row = edgeBits.data() + words * u;
+            for (const int *p = neighborBegin(u); p != neighborEnd(u); p++)
+                row[*p >> 6] |= (uint64_t)1 << (*p & 63);
+        }
+        bitRowWords = (int)words;
         return;
     }
     
-    list<int> unvisit;
+    edgeBits.clear();
+    edgeBits.shrink_to_fit();
+    bitRowWords = 0;
     
-    while(Vextension.size() != 0)
+    // Every undirected edge once
+    edgeHash.reset((size_t)rowOffsets[n] / 2);
+    for (int u = 0; u < n; u++)
+        for (const int *p = upper_bound(neighborBegin(u), neighborEnd(u), u);
+             p != neighborEnd(u); p++)
+            edgeHash.insert(u, *p);
+}
+
+
+//---------------------------------- display -----------------------------------
+// Display a all detailed path
+// Preconditions: vertices[vertexFrom] and its data must exist
+// Postconditions: all detailed path is displayed
+void Graph::display() const
+{
+    cout << "From\t\t";
+    cout << "To" << endl;
+    
+    for(int i = 0; i < vertexCount(); i++)
     {
-        int w = *Vextension.cbegin();
-        Vextension.erase(w);
-        
-        Vsubgraph.push_back(w);
-        visited.insert(w);
-        
-        unvisit.push_back(w);
-        
-        unordered_set<int> Vextension2 = unordered_set<int>(Vextension);
-        
-        for (int vertex : vertices[w])
+        if (degree(i) > 0)
         {
-            if (vertex > v && visited.count(vertex) == 0 && Vextension.count(vertex) == 0)
-                Vextension2.insert(vertex);
+            cout << originalId(i) << ": ";
+            
+            for (const int *p = neighborBegin(i); p != neighborEnd(i); p++)
+                cout << originalId(*p) << " ";
+            
+            cout << endl;
         }
-        
-        extendSubgraph(Vsubgraph, Vextension2, visited, v, k);
-        Vsubgraph.pop_back();
     }
+}
 
-    for(int i : unvisit)
-        visited.erase(i);
-
+//------------------------------ enumerateSubgraph -----------------------------
+// Enumerate size-k subgraphs of the original graph with a Census on
+// threads worker threads, within a budget of seconds and ESU tree nodes
+// (0 for no limit)
+// Preconditions: The graph should have already been built or exists;
+//                2 <= k
+// Postcondition: The number of subgraphs is displayed; if the budget ran
+//                out, the count of the finished roots and the estimated
+//                total are displayed instead
+void Graph::enumerateSubgraph(const int &k, const int &threads,
+                              const double &seconds, const long &nodes)
+{
+    Census census(*this, k, threads);
+    census.setBudget(seconds, nodes);
+    census.run();
+    count = census.total();
+    
+    if (census.complete())
+        cerr << count << endl;
+    else
+        census.display();
 }
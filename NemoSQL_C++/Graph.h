@@ -2,8 +2,11 @@
 //  Graph.h
 //  Created by Kunlakan Cherdchusilp, Ngoc Luu, Jonathan Earl, and Alan Nyugen
 //------------------------------------------------------------------------------
-// Graph is an undirected and unweigthed graph that is represented by adjacency
-// list of vertices that are connected to each other.
+// Graph is an undirected and unweigthed graph that is represented by an
+// immutable compressed sparse row (CSR) adjacency: the neighbors of vertex v
+// are stored sorted in neighbors[offsets[v]] .. neighbors[offsets[v + 1] - 1].
+// Input vertex IDs are compacted to 0 .. n-1 when the graph is built, and
+// originalId maps a vertex back to the ID it was read with.
 // features are included:
 //   -- allows adding and removing edges
 //   -- allows displaying of the whole Graph with distance and path
@@ -23,16 +26,26 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
-#include <list>
-#include <unordered_set>
 #include <climits>
+#include <utility>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include "Counter.h"
+#include "EdgeSet.h"
 
 using namespace std;
 
+class MappedFile;
+
 class Graph
 {
 public:
     
+    // Vertex numberings accepted by relabel
+    enum VertexOrder { NATURAL_ORDER, DEGREE_ORDER, BFS_ORDER };
+    
     //-------------------------- A Default Constructor -------------------------
     // Default constructor for class Graph
     // Preconditions: None
@@ -45,13 +58,92 @@ public:
     // Postconditions: None
     ~Graph();
     
+    //---------------------------- Copy Constructor ----------------------------
+    // Copy constructor and assignment for class Graph
+    // Preconditions: None
+    // Postconditions: This graph has the same adjacency as other. A graph
+    //                 backed by a snapshot shares the read-only mapping.
+    Graph(const Graph &other);
+    Graph &operator=(const Graph &other);
+    
     
     //------------------------------- buildGraph -------------------------------
     // Builds a graph by reading data from an ifstream
     // Preconditions:  infile has been successfully opened and the file contains
     //                 properly formated data (according to the program specs)
-    // Postconditions: A graph is read from infile and stored in the object
-    void buildGraph(ifstream &infile);
+    // Postconditions: Returns false, leaving the graph unchanged, if infile
+    //                 holds a negative vertex ID or one above INT_MAX.
+    //                 Otherwise a graph is read from infile and stored in the
+    //                 object
+    bool buildGraph(ifstream &infile);
+    
+    //------------------------------- buildGraph -------------------------------
+    // Builds a graph by memory mapping filename and scanning the "src dest"
+    // pairs in place. The mapping is cut into up to threads byte ranges
+    // aligned to line boundaries, and every range is parsed on its own thread.
+    // Each range is scanned twice, once to count its edges and once to fill
+    // an exactly sized buffer, so nothing is reallocated.
+    // Preconditions:  The file contains properly formated data (according to
+    //                 the program specs)
+    // Postconditions: Returns false, leaving the graph unchanged, if the file
+    //                 could not be mapped or holds a negative vertex ID or
+    //                 one above INT_MAX. Otherwise a graph is read from
+    //                 filename and stored in the object, with the input IDs
+    //                 compacted to 0 .. vertexCount()-1 in increasing order
+    //                 (see originalId)
+    bool buildGraph(const string &filename, const int &threads = 1);
+    
+    //------------------------------ writeSnapshot -----------------------------
+    // Write the graph in the binary snapshot format: a SnapshotHeader followed
+    // by the CSR offsets, the CSR neighbors and the original vertex IDs, each
+    // section starting on an 8-byte boundary. The header records the size and
+    // modification time of source, the file the graph was built from. The
+    // snapshot is written to a temporary file and renamed into place.
+    // Preconditions:  None
+    // Postconditions: Returns false if filename could not be written or
+    //                 source, if given, could not be examined; filename is
+    //                 then left as it was
+    bool writeSnapshot(const string &filename,
+                       const string &source = "") const;
+    
+    //------------------------------ loadSnapshot ------------------------------
+    // Map a file written by writeSnapshot and use its sections in place, with
+    // no parsing and no copy of the adjacency. The rows are checked to lie
+    // within the file and name only its vertices.
+    // Preconditions:  None
+    // Postconditions: Returns false, leaving the graph unchanged, if filename
+    //                 could not be mapped, is not a valid snapshot of this
+    //                 version, or, when source is given, was written from a
+    //                 source of another size or modification time. Otherwise
+    //                 the graph reads the mapped file.
+    bool loadSnapshot(const string &filename, const string &source = "");
+    
+    
+    //-------------------------------- relabel ---------------------------------
+    // Renumber the vertices in the given order. ESU only grows a subgraph
+    // from its lowest-numbered vertex, so the order also decides how the
+    // enumeration work is spread over the roots.
+    // Preconditions:  None
+    // Postconditions: The graph is isomorphic to before and originalId still
+    //                 maps every vertex to its input ID. DEGREE_ORDER numbers
+    //                 vertices by increasing degree, so hubs root few ESU
+    //                 trees. BFS_ORDER numbers each connected component
+    //                 breadth first, so neighbors get nearby IDs and nearby
+    //                 rows. NATURAL_ORDER restores increasing input ID order.
+    void relabel(const VertexOrder &order);
+    
+    //--------------------------------- rewire ---------------------------------
+    // Replace the edges by edges, keeping the vertices and their degrees, as
+    // a degree-preserving randomization does (see Randomizer). The rows and
+    // any edge index are refilled in place, so a graph rewired again and
+    // again reuses its memory.
+    // Preconditions:  edges is a simple graph on 0 .. vertexCount()-1 in
+    //                 which every vertex has its current degree
+    // Postconditions: The graph holds exactly edges, with every adjacency row
+    //                 sorted and originalId unchanged. An edge index, if
+    //                 built, is rebuilt; a snapshot-backed graph is copied
+    //                 into memory.
+    void rewire(const vector<pair<int, int>> &edges);
     
     
     //-------------------------------- display ---------------------------------
@@ -61,37 +153,159 @@ public:
     void display() const;
     
     
+    //------------------------------- vertexCount ------------------------------
+    // Number of vertices in the graph
+    // Preconditions: None
+    // Postconditions: Returns the number of rows in the CSR adjacency
+    int vertexCount() const { return n; }
+    
+    //--------------------------------- degree ---------------------------------
+    // Number of neighbors of vertex
+    // Preconditions: 0 <= vertex < vertexCount()
+    // Postconditions: Returns the length of the vertex's adjacency row
+    int degree(const int &vertex) const
+    { return rowOffsets[vertex + 1] - rowOffsets[vertex]; }
+    
+    //------------------------- neighborBegin/neighborEnd ----------------------
+    // Bounds of the sorted adjacency row of vertex
+    // Preconditions: 0 <= vertex < vertexCount()
+    // Postconditions: Returns pointers delimiting the neighbors of vertex
+    const int *neighborBegin(const int &vertex) const
+    { return rowNeighbors + rowOffsets[vertex]; }
+    const int *neighborEnd(const int &vertex) const
+    { return rowNeighbors + rowOffsets[vertex + 1]; }
+    
+    //-------------------------------- originalId ------------------------------
+    // ID of vertex in the input file
+    // Preconditions: 0 <= vertex < vertexCount()
+    // Postconditions: Returns the ID the vertex was read with
+    int originalId(const int &vertex) const { return vertexIds[vertex]; }
+    
+    
+    //----------------------------- buildEdgeIndex -----------------------------
+    // Build the secondary edge index used by hasEdge: a dense n-by-n bit
+    // matrix when it fits in MAX_BIT_MATRIX_BYTES, otherwise an open-addressed
+    // hash set of the edges probed four slots at a time
+    // Preconditions:  None
+    // Postconditions: hasEdge answers in constant time until the graph is
+    //                 rebuilt, relabeled or reloaded
+    void buildEdgeIndex();
+    
+    //--------------------------------- hasEdge --------------------------------
+    // Check whether u and v are adjacent
+    // Preconditions:  0 <= u, v < vertexCount()
+    // Postconditions: Returns true if the edge u-v exists. Without an edge
+    //                 index the sorted row of u is binary searched.
+    bool hasEdge(const int &u, const int &v) const
+    {
+        if (bitRowWords > 0)
+            return (edgeBits[(size_t)u * bitRowWords + (v >> 6)] >> (v & 63))
+                   & 1;
+        if (edgeHash.allocated())
+            return edgeHash.contains(u, v);
+        return binary_search(neighborBegin(u), neighborEnd(u), v);
+    }
+    
+    //------------------------------ adjacencyBits -----------------------------
+    // Row of the dense bit matrix for vertex
+    // Preconditions:  0 <= vertex < vertexCount()
+    // Postconditions: Returns the bitRowWords() words whose bit v is set when
+    //                 vertex and v are adjacent, or nullptr if the edge index
+    //                 is not a bit matrix
+    const uint64_t *adjacencyBits(const int &vertex) const
+    {
+        return bitRowWords > 0
+               ? edgeBits.data() + (size_t)vertex * bitRowWords : nullptr;
+    }
+    int adjacencyWords() const { return bitRowWords; }
+    
+    
     //--------------------------- enumerateSubgraph ----------------------------
-    // Enumerate size-k subgraphs of the original graph
-    // Preconditions: The graph should have already been built or exists
-    // Postcondition: The list of subgraphs are displayed
-    void enumerateSubgraph(const int &k);
+    // Enumerate size-k subgraphs of the original graph with a Census on
+    // threads worker threads, within a budget of seconds and ESU tree nodes
+    // (0 for no limit)
+    // Preconditions: The graph should have already been built or exists;
+    //                2 <= k
+    // Postcondition: The number of subgraphs is displayed; if the budget ran
+    //                out, the count of the finished roots and the estimated
+    //                total are displayed instead
+    void enumerateSubgraph(const int &k, const int &threads = 1,
+                           const double &seconds = 0.0,
+                           const long &nodes = 0);
     
     
 private:
-    int count = 0;                          // count number of motif found
-    vector<unordered_set<int>> vertices;            // adjacency list
+    Counter count;                          // count number of motif found
+    vector<int> offsets = vector<int>(1, 0);    // CSR row offsets, n + 1
+    vector<int> neighbors;                      // CSR sorted adjacency rows
+    vector<int> ids;                            // original ID of each vertex
     
+    // The enumeration reads the CSR through these views, which point either
+    // into the vectors above or into a mapped snapshot
+    int n = 0;                                  // number of vertices
+    const int *rowOffsets = offsets.data();
+    const int *rowNeighbors = neighbors.data();
+    const int *vertexIds = ids.data();
+    shared_ptr<const MappedFile> snapshot;      // mapping behind the views
     
-    //----------------------------- PRIVATE: exist -----------------------------
-    // Check if vertex already exists in the vector vertices
-    // Preconditions: None
-    // Postconditions: If vertex already exists in the vector vertices, then do
-    //                 nothing. Otherwise, add vertex to the vector vertices.
-    void exist(const int &vertex);
-    
-    //------------------------ PRIVATE: extendSubgraph -------------------------
-    // Recursively looking size-k subgraphs of the graph.
-    // Precondition: The graph should have already been built or exists
-    // Postcondition: The list of subgraphs are displayed
-    void extendSubgraph(list<int> &Vsubgraph, unordered_set<int> &Vextension, unordered_set<int> &visited, const int &v, const int &k);
-    
-    //-------------------------- PRIVATE: getExtension -------------------------
-    // Add all neighbors of vertex to Vextension
-    // Precondition: Vextension must be decalired and intialized before calling
-    //               this function.
-    // Postcondition: All neighbors of vertex are added to Vextension
-    void getExtension(unordered_set<int> &Vextension, const int &vertex);
+    // Secondary edge index, see buildEdgeIndex
+    vector<uint64_t> edgeBits;                  // dense n-by-n bit matrix
+    int bitRowWords = 0;                        // words per bit matrix row
+    EdgeSet edgeHash;                           // hash set of the edges
+    
+    static const size_t MAX_BIT_MATRIX_BYTES = 64 << 20;
+    
+    
+    //------------------------- PRIVATE: SnapshotHeader ------------------------
+    // Layout of the first bytes of a snapshot file. Section positions are
+    // byte offsets from the start of the file.
+    struct SnapshotHeader
+    {
+        char magic[8];                      // "NEMOCSR" and a zero byte
+        uint32_t version;                   // SNAPSHOT_VERSION
+        uint32_t byteOrder;                 // 0x01020304 as written
+        uint64_t vertexCount;               // rows in the CSR
+        uint64_t neighborCount;             // entries in the neighbor section
+        uint64_t offsetsAt;                 // vertexCount + 1 int32 values
+        uint64_t neighborsAt;               // neighborCount int32 values
+        uint64_t idsAt;                     // vertexCount int32 values
+        uint64_t sourceSize;                // bytes of the source file
+        uint64_t sourceModified;            // its mtime in nanoseconds
+    };
+    
+    static const uint32_t SNAPSHOT_VERSION = 2;
+    
+    
+    //--------------------------- PRIVATE: bindOwned ---------------------------
+    // Point the CSR views at the owned vectors
+    // Preconditions: offsets, neighbors and ids describe a complete graph
+    // Postconditions: Any snapshot mapping and any edge index are released
+    void bindOwned();
+    
+    
+    //--------------------------- PRIVATE: scanEdges ---------------------------
+    // Parse the "src dest" pairs of a line-aligned byte range
+    // Preconditions: [begin, end) starts at a line boundary and ends at a line
+    //                boundary or at the end of the file
+    // Postconditions: Returns false if the range holds a negative ID or one
+    //                 above INT_MAX; otherwise edges holds every complete
+    //                 pair of the range in order
+    static bool scanEdges(const char *begin, const char *end,
+                          vector<pair<int, int>> &edges);
+    
+    //--------------------------- PRIVATE: buildCSR ----------------------------
+    // Build the CSR adjacency from buffers of undirected edges with a parallel
+    // counting sort over threads threads, compacting the input IDs first
+    // Preconditions: Every endpoint in buffers is non-negative
+    // Postconditions: Only vertices with at least one edge other than a self
+    //                 loop are kept, numbered in increasing order of input
+    //                 ID, and ids maps them back. offsets and neighbors hold
+    //                 every edge in both directions with self loops and
+    //                 duplicate edges removed, and every adjacency row sorted
+    //                 in increasing order. buffers is rewritten to the
+    //                 compacted IDs.
+    void buildCSR(vector<vector<pair<int, int>>> &buffers,
+                  const int &threads);
     
     
 };
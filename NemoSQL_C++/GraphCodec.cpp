@@ -0,0 +1,452 @@
+//------------------------------------------------------------------------------
+//  GraphCodec.cpp
+//------------------------------------------------------------------------------
+// GraphCodec writes and reads nauty's graph6, digraph6 and sparse6 strings.
+// graph6 and digraph6 are a stream of adjacency bits cut into groups of six,
+// the first bit of a group its most significant, and each group written as
+// the byte 63 + group. graph6 gives the upper triangle column by column, so
+// column j is the low j bits of row j; digraph6 gives every row in full. A
+// row of the layout in GraphCodec.h is thus a run of bits taken from the
+// least significant end, and the codec moves up to 32 of them at a time
+// through a small buffer, where they sit least significant first; a group
+// leaves the buffer through a table reversing its six bits. sparse6 codes
+// each edge in a handful of bits, with no run of bits to move, and is
+// written and read a bit at a time exactly as in gtools.
+//
+// ASSUMPTIONS:
+//   -- As in GraphCodec.h
+//
+//------------------------------------------------------------------------------
+
+#include "GraphCodec.h"
+#include <algorithm>
+#include <climits>
+
+// Every six-bit group with its bits in reverse order
+static const unsigned char REVERSED[64] =
+{
+     0, 32, 16, 48,  8, 40, 24, 56,  4, 36, 20, 52, 12, 44, 28, 60,
+     2, 34, 18, 50, 10, 42, 26, 58,  6, 38, 22, 54, 14, 46, 30, 62,
+     1, 33, 17, 49,  9, 41, 25, 57,  5, 37, 21, 53, 13, 45, 29, 61,
+     3, 35, 19, 51, 11, 43, 27, 59,  7, 39, 23, 55, 15, 47, 31, 63,
+};
+
+static const int BIAS = 63;                 // byte of the group 0
+static const int SMALL_SIZE = 62;           // largest n in one size byte
+static const int SMALLISH_SIZE = 258047;    // largest n in four size bytes
+
+//---------------------------------- sizeLength --------------------------------
+// Bytes the size n takes in a string
+// Preconditions: n >= 0
+// Postconditions: Returns 1, 4 or 8
+static size_t sizeLength(const int &n)
+{
+    return n <= SMALL_SIZE ? 1 : n <= SMALLISH_SIZE ? 4 : 8;
+}
+
+//---------------------------------- writeSize ---------------------------------
+// Write the size n as encodegraphsize does
+// Preconditions: p has room for sizeLength(n) bytes
+// Postconditions: p points past the size
+static void writeSize(const int &n, char *&p)
+{
+    int groups = 1;
+    if (n > SMALLISH_SIZE)
+    {
+        *p++ = '~';
+        *p++ = '~';
+        groups = 6;
+    }
+    else if (n > SMALL_SIZE)
+    {
+        *p++ = '~';
+        groups = 3;
+    }
+    
+    for (int g = groups - 1; g >= 0; g--)
+        *p++ = (char)(BIAS + ((int64_t)n >> 6 * g & 63));
+}
+
+//---------------------------------- readSize ----------------------------------
+// Read a size as graphsize does
+// Preconditions: p <= end
+// Postconditions: Returns false if the bytes before end are not a size that
+//                 fits an int; otherwise n is the size and p points past it
+static bool readSize(const char *&p, const char *end, int &n)
+{
+    int groups = 1;
+    if (end - p >= 2 && p[0] == '~' && p[1] == '~')
+    {
+        p += 2;
+        groups = 6;
+    }
+    else if (end - p >= 1 && p[0] == '~')
+    {
+        p += 1;
+        groups = 3;
+    }
+    if (end - p < groups)
+        return false;
+    
+    int64_t size = 0;
+    for (int g = 0; g < groups; g++, p++)
+    {
+        if (*p < BIAS || *p > BIAS + 63)
+            return false;
+        size = size << 6 | (*p - BIAS);
+    }
+    if (size > INT_MAX)
+        return false;
+    
+    n = (int)size;
+    return true;
+}
+
+//-------------------------------- GroupWriter ---------------------------------
+// Writes runs of bits, each given least significant bit first, as groups of
+// six bits, first bit most significant
+struct GroupWriter
+{
+    char *p;                                // next byte to write
+    uint64_t pending = 0;                   // bits not yet written
+    int count = 0;                          // number of pending bits
+    
+    explicit GroupWriter(char *start) : p(start) {}
+    
+    // Write the low length bits of bits, length <= 32
+    void put(const uint64_t &bits, const int &length)
+    {
+        pending |= bits << count;
+        count += length;
+        while (count >= 6)
+        {
+            *p++ = (char)(BIAS + REVERSED[pending & 63]);
+            pending >>= 6;
+            count -= 6;
+        }
+    }
+    
+    // Write bits 0 .. length-1 of row
+    void putRow(const uint64_t *row, const int &length)
+    {
+        for (int i = 0; i < length; i += 32)
+        {
+            const int chunk = min(32, length - i);
+            put(row[i / 64] >> i % 64 & ((1ULL << chunk) - 1), chunk);
+        }
+    }
+    
+    // Write the last group, padded with 0
+    void flush()
+    {
+        if (count > 0)
+            *p++ = (char)(BIAS + REVERSED[pending & 63]);
+        pending = 0;
+        count = 0;
+    }
+};
+
+//-------------------------------- GroupReader ---------------------------------
+// Reads groups of six bits, first bit most significant, as runs of bits
+// least significant bit first
+struct GroupReader
+{
+    const char *p;                          // next byte to read
+    const char *end;                        // end of the groups
+    uint64_t pending = 0;                   // bits read but not taken
+    int count = 0;                          // number of pending bits
+    
+    GroupReader(const char *start, const char *stop) : p(start), end(stop) {}
+    
+    // Take the next length bits, length <= 32; false if they run past end
+    bool take(const int &length, uint64_t &bits)
+    {
+        while (count < length)
+        {
+            if (p == end || *p < BIAS || *p > BIAS + 63)
+                return false;
+            pending |= (uint64_t)REVERSED[*p++ - BIAS] << count;
+            count += 6;
+        }
+        bits = pending & ((1ULL << length) - 1);
+        pending >>= length;
+        count -= length;
+        return true;
+    }
+};
+
+
+//--------------------------------- encodeGraph6 -------------------------------
+// Append the graph6 string of an undirected graph
+// Preconditions: rows hold the graph in the layout of GraphCodec.h
+// Postconditions: out has grown by the string ntog6 writes, less its newline
+void GraphCodec::encodeGraph6(const uint64_t *rows, const int &n, string &out)
+{
+    const size_t words = rowWords(n);
+    const uint64_t bits = n > 1 ? (uint64_t)n * (n - 1) / 2 : 0;
+    const size_t start = out.size();
+    out.resize(start + sizeLength(n) + (bits + 5) / 6);
+    
+    char *p = &out[start];
+    writeSize(n, p);
+    GroupWriter writer(p);
+    for (int j = 1; j < n; j++)
+        writer.putRow(rows + j * words, j);
+    writer.flush();
+}
+
+//-------------------------------- encodeDigraph6 ------------------------------
+// Append the digraph6 string of a directed graph
+// Preconditions: rows hold the graph in the layout of GraphCodec.h
+// Postconditions: out has grown by the string ntod6 writes, less its newline
+void GraphCodec::encodeDigraph6(const uint64_t *rows, const int &n,
+                                string &out)
+{
+    const size_t words = rowWords(n);
+    const uint64_t bits = (uint64_t)n * n;
+    const size_t start = out.size();
+    out.resize(start + 1 + sizeLength(n) + (bits + 5) / 6);
+    
+    char *p = &out[start];
+    *p++ = '&';
+    writeSize(n, p);
+    GroupWriter writer(p);
+    for (int i = 0; i < n; i++)
+        writer.putRow(rows + i * words, n);
+    writer.flush();
+}
+
+//-------------------------------- encodeSparse6 -------------------------------
+// Append the sparse6 string of an undirected graph
+// Preconditions: Every edge joins vertices below n, in either order
+// Postconditions: out has grown by the string ntos6 writes for the same
+//                 graph, less its newline; a repeated edge is written once
+void GraphCodec::encodeSparse6(const int &n,
+                               const vector<pair<int, int>> &edges,
+                               string &out)
+{
+    // ntos6 visits the edges (i, j), i <= j, by j and then by i, and reads
+    // them from a matrix, which holds each edge once
+    vector<pair<int, int>> order;
+    order.reserve(edges.size());
+    for (const pair<int, int> &edge : edges)
+        order.push_back(make_pair(max(edge.first, edge.second),
+                                  min(edge.first, edge.second)));
+    sort(order.begin(), order.end());
+    order.erase(unique(order.begin(), order.end()), order.end());
+    
+    int nb = 0;                             // bits in a vertex number
+    while (nb < 31 && ((int64_t)1 << nb) < n)
+        nb++;
+    
+    out.reserve(out.size() + 1 + sizeLength(n) +
+                (order.size() * (2 * nb + 2) + 5) / 6);
+    char size[8];
+    char *p = size;
+    writeSize(n, p);
+    out += ':';
+    out.append(size, p);
+    
+    // Bits go out first bit most significant, k bits short of a full group
+    int x = 0;
+    int k = 6;
+    auto put = [&](const int &value, const int &length)
+    {
+        for (int b = length - 1; b >= 0; b--)
+        {
+            x = x << 1 | (value >> b & 1);
+            if (--k == 0)
+            {
+                out += (char)(BIAS + x);
+                x = 0;
+                k = 6;
+            }
+        }
+    };
+    
+    // Each edge is a bit b and the number of i; b = 1 moves on to the next
+    // j, and a j further on is written out, after a b = 1 and before a 0
+    int lastj = 0;
+    for (const pair<int, int> &edge : order)
+    {
+        const int j = edge.first;
+        const int i = edge.second;
+        if (j == lastj)
+            put(0, 1);
+        else
+        {
+            put(1, 1);
+            if (j > lastj + 1)
+            {
+                put(j, nb);
+                put(0, 1);
+            }
+            lastj = j;
+        }
+        put(i, nb);
+    }
+    
+    // Pad with 1s, except where that would read as one more edge (n - 1, 0)
+    if (k != 6)
+    {
+        if (k >= nb + 1 && lastj == n - 2 && (int64_t)n == (int64_t)1 << nb)
+            out += (char)(BIAS + ((x << k) | ((1 << (k - 1)) - 1)));
+        else
+            out += (char)(BIAS + ((x << k) | ((1 << k) - 1)));
+    }
+}
+
+//------------------------------- encodeTriangles ------------------------------
+// Append the graph6 strings of a batch of small graphs, one per line
+// Preconditions: n <= 16; each triangle is below 2^(n(n-1)/2)
+// Postconditions: out has grown by count lines, each ended by '\n'
+void GraphCodec::encodeTriangles(const unsigned __int128 *triangles,
+                                 const size_t &count, const int &n,
+                                 string &out)
+{
+    // Every line has the same length, and the triangle is already the bit
+    // stream of graph6, least significant bit first
+    const int groups = (n * (n - 1) / 2 + 5) / 6;
+    const size_t start = out.size();
+    out.resize(start + count * (groups + 2));
+    
+    char *p = &out[start];
+    for (size_t g = 0; g < count; g++)
+    {
+        *p++ = (char)(BIAS + n);
+        unsigned __int128 triangle = triangles[g];
+        for (int t = 0; t < groups; t++, triangle >>= 6)
+            *p++ = (char)(BIAS + REVERSED[(int)triangle & 63]);
+        *p++ = '\n';
+    }
+}
+
+//------------------------------------ decode ----------------------------------
+// Read a graph6, digraph6 or sparse6 string
+// Preconditions: None
+// Postconditions: Returns false if line is malformed; otherwise n and rows
+//                 hold the graph
+bool GraphCodec::decode(const string &line, int &n, vector<uint64_t> &rows)
+{
+    if (!line.empty() && line[0] == ':')
+    {
+        vector<pair<int, int>> edges;
+        if (!decodeSparse6(line, n, edges))
+            return false;
+    
+        const size_t words = rowWords(n);
+        rows.assign(n * words, 0);
+        for (const pair<int, int> &edge : edges)
+        {
+            const int u = edge.first;
+            const int v = edge.second;
+            rows[u * words + v / 64] |= 1ULL << v % 64;
+            rows[v * words + u / 64] |= 1ULL << u % 64;
+        }
+        return true;
+    }
+    
+    const char *p = line.data();
+    const char *end = p + line.size();
+    if (end != p && end[-1] == '\n')
+        end--;
+    const bool directed = p != end && *p == '&';
+    if (directed)
+        p++;
+    if (!readSize(p, end, n))
+        return false;
+    
+    const size_t words = rowWords(n);
+    rows.assign(n * words, 0);
+    GroupReader reader(p, end);
+    uint64_t bits;
+    if (directed)
+    {
+        for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j += 32)
+            {
+                if (!reader.take(min(32, n - j), bits))
+                    return false;
+                rows[i * words + j / 64] |= bits << j % 64;
+            }
+    }
+    else
+    {
+        // Column j of the triangle is the low j bits of row j, and each
+        // bit set there is mirrored into column j of the rows above
+        for (int j = 1; j < n; j++)
+            for (int i = 0; i < j; i += 32)
+            {
+                if (!reader.take(min(32, j - i), bits))
+                    return false;
+                rows[j * words + i / 64] |= bits << i % 64;
+                for (; bits != 0; bits &= bits - 1)
+                {
+                    const int v = i + __builtin_ctzll(bits);
+                    rows[v * words + j / 64] |= 1ULL << j % 64;
+                }
+            }
+    }
+    
+    // Only the padding of the last group may remain
+    return reader.p == end;
+}
+
+//-------------------------------- decodeSparse6 -------------------------------
+// Read a sparse6 string into an edge list
+// Preconditions: None
+// Postconditions: Returns false if line is malformed; otherwise n is the
+//                 number of vertices and edges lists (u, v), u <= v
+bool GraphCodec::decodeSparse6(const string &line, int &n,
+                               vector<pair<int, int>> &edges)
+{
+    const char *p = line.data();
+    const char *end = p + line.size();
+    if (end != p && end[-1] == '\n')
+        end--;
+    if (p == end || *p++ != ':' || !readSize(p, end, n))
+        return false;
+    
+    int nb = 0;
+    while (nb < 31 && ((int64_t)1 << nb) < n)
+        nb++;
+    
+    // As in stringtograph: bit b moves on to the next vertex v when set,
+    // then a number j either jumps to vertex j, if j > v, or is an edge
+    // (j, v); the string ends part way through the padding
+    edges.clear();
+    int x = 0;
+    int k = 0;
+    auto get = [&](const int &length, int &value)
+    {
+        value = 0;
+        for (int b = 0; b < length; b++)
+        {
+            if (k == 0)
+            {
+                if (p == end)
+                    return false;
+                x = *p++ - BIAS;
+                k = 6;
+            }
+            value = value << 1 | (x >> --k & 1);
+        }
+        return true;
+    };
+    
+    for (const char *q = p; q != end; q++)
+        if (*q < BIAS || *q > BIAS + 63)
+            return false;
+    
+    int64_t v = 0;
+    int b, j;
+    while (get(1, b) && get(nb, j))
+    {
+        v += b;
+        if (j > v)
+            v = j;
+        else if (v < n)
+            edges.push_back(make_pair(j, (int)v));
+    }
+    return true;
+}
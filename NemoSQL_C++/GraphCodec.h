@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+//  GraphCodec.h
+//------------------------------------------------------------------------------
+// GraphCodec converts graphs to and from nauty's text formats: graph6 for
+// undirected graphs, digraph6 for directed ones and sparse6 for sparse ones.
+// The strings are byte for byte those of gtools (ntog6, ntod6, ntos6), and
+// decode reads all three as stringtograph does, so census output can be piped
+// straight into the nauty tools and back.
+//
+// A dense graph on n vertices is given as n rows of rowWords(n) words each,
+// row i starting at rows[i * rowWords(n)], bit v % 64 of word v / 64 set
+// when there is an edge from i to v. This is the layout of the bit matrix of
+// Graph (adjacencyBits), not nauty's, whose bits run from the top of a word.
+// A sparse graph is given as a list of edges.
+//
+// The encoders append to a string without a trailing newline, except for
+// encodeTriangles, which writes a batch of small graphs one per line. They
+// size the output once and then move whole words of adjacency bits at a
+// time, so a batch costs little more than the bytes it writes.
+//
+// ASSUMPTIONS:
+//   -- 0 <= n <= INT_MAX, and rows hold n * rowWords(n) words
+//   -- Graphs given to encodeGraph6 are undirected: only the bits below the
+//      diagonal of the matrix are read
+//   -- Edge lists name vertices 0 .. n-1
+//
+//------------------------------------------------------------------------------
+
+#ifndef __GraphCodec__
+#define __GraphCodec__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class GraphCodec
+{
+public:
+    
+    //------------------------------ encodeGraph6 ------------------------------
+    // Append the graph6 string of an undirected graph
+    // Preconditions: rows hold the graph in the layout above
+    // Postconditions: out has grown by the string ntog6 writes, less its
+    //                 newline
+    static void encodeGraph6(const uint64_t *rows, const int &n, string &out);
+    
+    //----------------------------- encodeDigraph6 -----------------------------
+    // Append the digraph6 string of a directed graph
+    // Preconditions: rows hold the graph in the layout above
+    // Postconditions: out has grown by the string ntod6 writes, less its
+    //                 newline
+    static void encodeDigraph6(const uint64_t *rows, const int &n,
+                               string &out);
+    
+    //------------------------------ encodeSparse6 -----------------------------
+    // Append the sparse6 string of an undirected graph
+    // Preconditions: Every edge joins vertices below n, in either order; an
+    //                edge (v, v) is a loop
+    // Postconditions: out has grown by the string ntos6 writes for the same
+    //                 graph, less its newline. A repeated edge is written
+    //                 once, since a nauty graph cannot hold it twice.
+    static void encodeSparse6(const int &n,
+                              const vector<pair<int, int>> &edges,
+                              string &out);
+    
+    //----------------------------- encodeTriangles ----------------------------
+    // Append the graph6 strings of a batch of small graphs, one per line
+    // Preconditions: n <= 16; each triangle holds the upper triangle of a
+    //                graph packed in graph6 order, as a ClassKey does, and is
+    //                below 2^(n(n-1)/2)
+    // Postconditions: out has grown by count lines, each ended by '\n'
+    static void encodeTriangles(const unsigned __int128 *triangles,
+                                const size_t &count, const int &n,
+                                string &out);
+    
+    //--------------------------------- decode ---------------------------------
+    // Read a graph6, digraph6 or sparse6 string, told apart as gtools does
+    // by its first byte
+    // Preconditions: None
+    // Postconditions: Returns false if line is malformed. Otherwise n is
+    //                 the number of vertices and rows hold the graph in the
+    //                 layout above, both directions of every edge set unless
+    //                 line is a digraph6 string.
+    static bool decode(const string &line, int &n, vector<uint64_t> &rows);
+    
+    //------------------------------ decodeSparse6 -----------------------------
+    // Read a sparse6 string into an edge list, without building a matrix
+    // Preconditions: None
+    // Postconditions: Returns false if line is malformed. Otherwise n is
+    //                 the number of vertices and edges lists (u, v), u <= v,
+    //                 in the order the string gives them.
+    static bool decodeSparse6(const string &line, int &n,
+                              vector<pair<int, int>> &edges);
+    
+    //-------------------------------- rowWords --------------------------------
+    // Words per row of a dense graph on n vertices
+    // Preconditions: n >= 0
+    // Postconditions: Returns ceil(n / 64)
+    static size_t rowWords(const int &n) { return ((size_t)n + 63) / 64; }
+};
+
+#endif /* defined(__GraphCodec__) */
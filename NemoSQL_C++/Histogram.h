@@ -0,0 +1,158 @@
+//------------------------------------------------------------------------------
+//  Histogram.h
+//------------------------------------------------------------------------------
+// Histogram holds the subgraph counts of one census worker by dense class
+// ID. Only the owning thread adds to it, so an increment is a plain load and
+// store with no read-modify-write. The owner and other threads reading a
+// histogram while its owner is still counting access a slot with relaxed
+// atomic loads and stores; once the owner has stopped, addTo merges the
+// slots with plain loads, a cache line at a time, which the compiler turns
+// into vector adds. The slots start on a cache line of their own, so that
+// the histograms of different workers never share one. As in Counter, a
+// carry out of the 64-bit low word goes to a high word, kept apart since it
+// is rarely used.
+//
+// ASSUMPTIONS:
+//   -- Only one thread adds to a histogram
+//   -- A reader racing with the owner may see a count that is slightly
+//      behind, or torn at the moment a low word wraps
+//
+//------------------------------------------------------------------------------
+
+#ifndef __Histogram__
+#define __Histogram__
+
+#include "Counter.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+class Histogram
+{
+public:
+    
+    //--------------------------------- assign ---------------------------------
+    // Make size zero slots, reusing the slots there are if size is unchanged
+    // Preconditions: No other thread uses the histogram
+    // Postconditions: size() == size and every count is 0
+    void assign(const int &size)
+    {
+        const int lines = (size + PER_LINE - 1) / PER_LINE;
+        if (size != slots)
+        {
+            lows.reset(new Line[lines]());
+            highs.reset(new uint64_t[size]());
+            slots = size;
+            return;
+        }
+        
+        for (int line = 0; line < lines; line++)
+            fill_n(lows[line].words, PER_LINE, 0);
+        fill_n(highs.get(), slots, 0);
+    }
+    
+    //---------------------------------- size ----------------------------------
+    // Number of slots
+    // Preconditions: None
+    // Postconditions: Returns the size given to assign, or 0
+    int size() const { return slots; }
+    
+    //----------------------------------- add ----------------------------------
+    // Add count to slot id
+    // Preconditions: Called only by the owning thread; 0 <= id < size()
+    // Postconditions: A carry out of the low word goes to the high word
+    void add(const int &id, const uint64_t &count = 1)
+    {
+        uint64_t &low = lows[id / PER_LINE].words[id % PER_LINE];
+        uint64_t sum;
+        const bool carry = __builtin_add_overflow(
+            __atomic_load_n(&low, __ATOMIC_RELAXED), count, &sum);
+        __atomic_store_n(&low, sum, __ATOMIC_RELAXED);
+        if (carry)
+            addHigh(id, 1);
+    }
+    
+    void add(const int &id, const Counter &count)
+    {
+        if (count.highWord() != 0)
+            addHigh(id, count.highWord());
+        add(id, count.lowWord());
+    }
+    
+    //----------------------------------- at -----------------------------------
+    // Count of slot id
+    // Preconditions: 0 <= id < size()
+    // Postconditions: Returns the count, as of some recent add if the owner
+    //                 is adding concurrently
+    Counter at(const int &id) const
+    {
+        const uint64_t high = __atomic_load_n(&highs[id], __ATOMIC_RELAXED);
+        return Counter(__atomic_load_n(&lows[id / PER_LINE].words[id %
+                                       PER_LINE], __ATOMIC_RELAXED), high);
+    }
+    
+    //------------------------------ addRecentTo -------------------------------
+    // Add every count to sums, element by element, while the owner may still
+    // be adding
+    // Preconditions: sums.size() >= size()
+    // Postconditions: sums[id] has grown by at(id) for every slot
+    void addRecentTo(vector<Counter> &sums) const
+    {
+        for (int id = 0; id < slots; id++)
+            sums[id] += at(id);
+    }
+    
+    //--------------------------------- addTo ----------------------------------
+    // Add every count to sums, element by element
+    // Preconditions: sums.size() >= size(); the owner has stopped adding,
+    //                and its adds happen before this call
+    // Postconditions: sums[id] has grown by at(id) for every slot
+    void addTo(vector<Counter> &sums) const
+    {
+        const int lines = slots / PER_LINE;
+        for (int line = 0; line < lines; line++)
+        {
+            // Carries come from the top bits rather than a compare, which
+            // SSE2 lacks for 64-bit words, so the eight slots add as vectors
+            Counter *__restrict sum = &sums[line * PER_LINE];
+            const uint64_t *__restrict low = lows[line].words;
+            const uint64_t *__restrict high = &highs[line * PER_LINE];
+            for (int i = 0; i < PER_LINE; i++)
+            {
+                const uint64_t a = sum[i].lowWord(), b = low[i], word = a + b;
+                const uint64_t carry = ((a & b) | ((a | b) & ~word)) >> 63;
+                sum[i] = Counter(word, sum[i].highWord() + high[i] + carry);
+            }
+        }
+        for (int id = lines * PER_LINE; id < slots; id++)
+            sums[id] += at(id);
+    }
+    
+    
+private:
+    static const int PER_LINE = 8;          // low words per cache line
+    
+    struct alignas(64) Line
+    {
+        uint64_t words[PER_LINE];
+    };
+    
+    //---------------------------- PRIVATE: addHigh ----------------------------
+    // Add carries to the high word of slot id
+    // Preconditions: Called only by the owning thread
+    // Postconditions: The high word has grown by carries
+    void addHigh(const int &id, const uint64_t &carries)
+    {
+        __atomic_store_n(&highs[id], __atomic_load_n(&highs[id],
+                         __ATOMIC_RELAXED) + carries, __ATOMIC_RELAXED);
+    }
+    
+    unique_ptr<Line[]> lows;                // low words, by line
+    unique_ptr<uint64_t[]> highs;           // carries out of the low words
+    int slots = 0;                          // see size
+};
+
+#endif /* defined(__Histogram__) */
@@ -0,0 +1,267 @@
+//------------------------------------------------------------------------------
+//  IncrementalCensus.cpp
+//------------------------------------------------------------------------------
+// IncrementalCensus updates class counts across an edge switch by counting,
+// before and after it, the connected size-k vertex sets that hold both ends
+// of a switched pair. The sets of a pair u-v are grown from u as in ESU: a
+// candidate joins the set, and its neighbors that are neither members nor
+// adjacent to a member become candidates for the sets below it. Only the
+// root ordering of ESU is left out, so sets are counted from u alone. The
+// candidates of every depth are a slice of one flat stack, as in ESUEngine,
+// but a set's slice also starts inside its parent's, at the candidates after
+// the one it added, so nothing is copied from depth to depth. A vertex joins
+// the stack only while no member is adjacent to it, and then its neighbor
+// is one, so it is never there twice and n slots suffice. The hop distances
+// to v bound every branch, and are kept only for the few vertices within
+// k - 1 hops of v, so a switch costs time near the switched edges and not in
+// the size of the graph.
+//
+// ASSUMPTIONS:
+//   -- As in IncrementalCensus.h
+//
+//------------------------------------------------------------------------------
+
+#include "IncrementalCensus.h"
+#include "Census.h"
+#include <algorithm>
+
+//--------------------------------- Constructor --------------------------------
+// Start from a classifying Census of graph on threads threads
+// Preconditions: 2 <= k <= Classifier::MAX_SIZE
+// Postconditions: total() and classCounts() are those of graph
+IncrementalCensus::IncrementalCensus(const Graph &graph, const int &k,
+                                     const int &threads)
+    : k(k), n(graph.vertexCount()), classifier(k), distance(n, k),
+      blocked(n, 0), members(k), candidates(n), rows(k)
+{
+    Census census(graph, k, threads);
+    census.setClassification();
+    census.run();
+    subgraphs = census.total();
+    classes = census.classCounts();
+    
+    offsets.assign(n + 1, 0);
+    for (int v = 0; v < n; v++)
+        offsets[v + 1] = offsets[v] + graph.degree(v);
+    neighbors.assign(graph.neighborBegin(0), graph.neighborBegin(0) +
+                                             offsets[n]);
+    
+    edgeSet.reset(offsets[n] / 2);
+    for (int u = 0; u < n; u++)
+        for (const int *p = graph.neighborBegin(u); p != graph.neighborEnd(u);
+             p++)
+            if (u < *p)
+                edgeSet.insert(u, *p);
+}
+
+
+//---------------------------------- swapEdges ---------------------------------
+// Replace the edges a-b and c-d by a-d and c-b and update the counts
+// Preconditions: None
+// Postconditions: Returns false, changing nothing, if the switch is not
+//                 valid; otherwise the counts are those of the new graph
+bool IncrementalCensus::swapEdges(const int &a, const int &b, const int &c,
+                                  const int &d)
+{
+    if (a == d || c == b || !edgeSet.contains(a, b) ||
+        !edgeSet.contains(c, d) || edgeSet.contains(a, d) ||
+        edgeSet.contains(c, b))
+        return false;
+    
+    pairs[0] = make_pair(a, b);
+    pairs[1] = make_pair(c, d);
+    pairs[2] = make_pair(a, d);
+    pairs[3] = make_pair(c, b);
+    
+    adding = false;
+    enumerate();
+    
+    edgeSet.erase(a, b);
+    edgeSet.erase(c, d);
+    edgeSet.insert(a, d);
+    edgeSet.insert(c, b);
+    replace(a, b, d);
+    replace(b, a, c);
+    replace(c, d, b);
+    replace(d, c, a);
+    
+    adding = true;
+    enumerate();
+    
+    return true;
+}
+
+//------------------------------------ follow ----------------------------------
+// Run the chain of randomizer for switches accepted switches and follow
+// every switch here
+// Preconditions: The current graph of randomizer is this graph
+// Postconditions: Returns the switches accepted
+long IncrementalCensus::follow(Randomizer &randomizer, const long &switches,
+                               const int &tries)
+{
+    const long attempts = switches * max(1, tries);
+    long accepted = 0;
+    Randomizer::Switch s;
+    for (long attempt = 0; attempt < attempts && accepted < switches;
+         attempt++)
+        if (randomizer.propose(s))
+        {
+            randomizer.apply(s);
+            swapEdges(s.a, s.b, s.c, s.d);
+            accepted++;
+        }
+    
+    return accepted;
+}
+
+
+//----------------------------- PRIVATE: enumerate -----------------------------
+// Take away, or add, the classes of every connected size-k vertex set
+// holding one of the pairs in the current graph
+// Preconditions: pairs holds the pairs of the switch
+// Postconditions: Every such set was counted once, with its first pair
+void IncrementalCensus::enumerate()
+{
+    for (target = 0; target < 4; target++)
+    {
+        const int u = pairs[target].first;
+        const int v = pairs[target].second;
+    
+        // Hops to v, up to k - 1; a set of k vertices holding u and v lies
+        // within that many hops of v
+        distance[v] = 0;
+        reached.assign(1, v);
+        for (size_t head = 0; head < reached.size(); head++)
+        {
+            const int x = reached[head];
+            if (distance[x] == k - 1)
+                continue;
+            for (int i = offsets[x]; i < offsets[x + 1]; i++)
+                if (distance[neighbors[i]] == k)
+                {
+                    distance[neighbors[i]] = distance[x] + 1;
+                    reached.push_back(neighbors[i]);
+                }
+        }
+    
+        if (distance[u] < k)
+        {
+            members[0] = u;
+            copy(neighbors.begin() + offsets[u],
+                 neighbors.begin() + offsets[u + 1], candidates.begin());
+            block(u);
+            grow(1, distance[u], 0, offsets[u + 1] - offsets[u]);
+            unblock(u);
+        }
+    
+        for (int x : reached)
+            distance[x] = k;
+    }
+}
+
+//-------------------------------- PRIVATE: grow -------------------------------
+// Grow members[0 .. size-1] by the candidates[begin .. end-1]
+// Preconditions: size < k; the members are connected and blocked; nearest,
+//                the least distance of a member to the far end, is at most
+//                k - size; no slot of candidates from end on is in use
+// Postconditions: Every size-k set extending the members and holding the
+//                 far end has been counted; candidates[begin .. end-1] are
+//                 unchanged
+void IncrementalCensus::grow(const int &size, const int &nearest,
+                             const int &begin, const int &end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        // Each vertex added brings the far end at most one hop closer, so
+        // most candidates are dropped before their neighbors are read
+        const int w = candidates[i];
+        const int closest = min(nearest, distance[w]);
+        if (closest > k - size - 1)
+            continue;
+        members[size] = w;
+        if (size + 1 == k)
+        {
+            count();
+            continue;
+        }
+    
+        // The candidates of w are the later ones here, which stay in place,
+        // and above them the neighbors w adds. A set below only writes
+        // above its own candidates, so this slice survives it.
+        int top = end;
+        for (int j = offsets[w]; j < offsets[w + 1]; j++)
+            if (blocked[neighbors[j]] == 0)
+                candidates[top++] = neighbors[j];
+    
+        block(w);
+        grow(size + 1, closest, i + 1, top);
+        unblock(w);
+    }
+}
+
+//------------------------------- PRIVATE: count -------------------------------
+// Count the full set in members
+// Preconditions: members holds k vertices forming a connected set with the
+//                pair target
+// Postconditions: Its class is counted unless an earlier pair is in it
+void IncrementalCensus::count()
+{
+    for (int earlier = 0; earlier < target; earlier++)
+        if (find(members.begin(), members.end(), pairs[earlier].first) !=
+                members.end() &&
+            find(members.begin(), members.end(), pairs[earlier].second) !=
+                members.end())
+            return;
+    
+    for (int i = 0; i < k; i++)
+        rows[i] = 0;
+    for (int i = 1; i < k; i++)
+        for (int j = 0; j < i; j++)
+            if (edgeSet.contains(members[i], members[j]))
+            {
+                rows[i] |= 1ULL << j;
+                rows[j] |= 1ULL << i;
+            }
+    
+    const ClassKey key = classifier.classify(rows.data());
+    if (adding)
+    {
+        classes[key] += 1;
+        subgraphs += 1;
+        return;
+    }
+    
+    ClassCounts::iterator found = classes.find(key);
+    found->second -= 1;
+    if (found->second == Counter())
+        classes.erase(found);
+    subgraphs -= 1;
+}
+
+//--------------------------- PRIVATE: block/unblock ---------------------------
+// Mark, or unmark, v and its neighbors as members or adjacent to one
+// Preconditions: unblock(v) follows a block(v)
+// Postconditions: blocked[x] counts the members equal or adjacent to x
+void IncrementalCensus::block(const int &v)
+{
+    blocked[v]++;
+    for (int i = offsets[v]; i < offsets[v + 1]; i++)
+        blocked[neighbors[i]]++;
+}
+
+void IncrementalCensus::unblock(const int &v)
+{
+    blocked[v]--;
+    for (int i = offsets[v]; i < offsets[v + 1]; i++)
+        blocked[neighbors[i]]--;
+}
+
+//------------------------------ PRIVATE: replace ------------------------------
+// Replace neighbor from by to in the row of v
+// Preconditions: from is in the row of v
+// Postconditions: to is in the row of v instead
+void IncrementalCensus::replace(const int &v, const int &from, const int &to)
+{
+    *find(neighbors.begin() + offsets[v], neighbors.begin() + offsets[v + 1],
+          from) = to;
+}
@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------
+//  IncrementalCensus.h
+//------------------------------------------------------------------------------
+// IncrementalCensus keeps the class counts of the size-k subgraphs of a
+// graph up to date while its edges are switched, as in a Randomizer chain,
+// so that the census of each graph along the chain costs a small local
+// enumeration instead of a whole new Census.
+//
+// A switch of a-b and c-d for a-d and c-b changes the subgraph induced by a
+// vertex set exactly when the set holds both ends of one of the four pairs
+// a-b, c-d, a-d and c-b. swapEdges enumerates the connected size-k vertex
+// sets holding a pair, before the switch to take away their classes and
+// after it to add the new ones. A set is enumerated from one end of the
+// pair, growing it by ESU's exclusive neighborhoods but with no vertex
+// ordering, which finds every connected set holding that end exactly once.
+// A partial set is dropped as soon as the other end is more hops away than
+// the vertices still to add, found by a breadth-first search from the
+// other end, and a set holding two of the pairs is counted only with the
+// first.
+//
+// The graph is kept as CSR rows of fixed length, since a switch never
+// changes a degree, and as an EdgeSet for the adjacency tests of the
+// classification.
+//
+// ASSUMPTIONS:
+//   -- The Graph is simple
+//   -- 2 <= k <= Classifier::MAX_SIZE
+//   -- An IncrementalCensus is used by one thread
+//
+//------------------------------------------------------------------------------
+
+#ifndef __IncrementalCensus__
+#define __IncrementalCensus__
+
+#include "Classifier.h"
+#include "Counter.h"
+#include "EdgeSet.h"
+#include "Graph.h"
+#include "Randomizer.h"
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class IncrementalCensus
+{
+public:
+    
+    //------------------------------- Constructor ------------------------------
+    // Start from a classifying Census of graph on threads threads
+    // Preconditions: 2 <= k <= Classifier::MAX_SIZE
+    // Postconditions: total() and classCounts() are those of graph
+    IncrementalCensus(const Graph &graph, const int &k,
+                      const int &threads = 1);
+    
+    
+    //-------------------------------- swapEdges -------------------------------
+    // Replace the edges a-b and c-d by a-d and c-b and update the counts
+    // Preconditions: None
+    // Postconditions: Returns false, changing nothing, if a-b or c-d is not
+    //                 an edge, a-d or c-b is, or either would be a loop.
+    //                 Otherwise the counts are those of the new graph.
+    bool swapEdges(const int &a, const int &b, const int &c, const int &d);
+    
+    //--------------------------------- follow ---------------------------------
+    // Run the chain of randomizer for switches accepted switches, giving up
+    // after tries attempts per switch, and follow every switch here
+    // Preconditions: The current graph of randomizer is this graph
+    // Postconditions: Returns the switches accepted; both still hold the
+    //                 same graph, and the counts are those of that graph
+    long follow(Randomizer &randomizer, const long &switches,
+                const int &tries = 3);
+    
+    //---------------------------------- total ---------------------------------
+    // Number of connected size-k subgraphs of the current graph
+    // Preconditions: None
+    // Postconditions: Returns the sum of classCounts()
+    Counter total() const { return subgraphs; }
+    
+    //------------------------------- classCounts ------------------------------
+    // Subgraphs of the current graph by class (see Classifier)
+    // Preconditions: None
+    // Postconditions: Holds every class with at least one subgraph
+    const ClassCounts &classCounts() const { return classes; }
+    
+    
+private:
+    const int k;                            // subgraph size
+    const int n;                            // number of vertices
+    vector<int> offsets;                    // row offsets, fixed by degree
+    vector<int> neighbors;                  // adjacency rows, unsorted
+    EdgeSet edgeSet;                        // the same edges, for lookups
+    Classifier classifier;                  // classes of the subgraphs
+    Counter subgraphs;                      // see total
+    ClassCounts classes;                    // see classCounts
+    
+    // State of the enumeration around one switch
+    pair<int, int> pairs[4];                // a-b, c-d, a-d, c-b
+    int target = 0;                         // pair being enumerated
+    bool adding = false;                    // add the classes, not subtract
+    vector<int> distance;                   // hops to the far end, or k
+    vector<int> reached;                    // vertices with distance < k
+    vector<int> blocked;                    // members equal or adjacent
+    vector<int> members;                    // set being grown
+    vector<int> candidates;                 // flat stack of the slices
+    vector<uint64_t> rows;                  // adjacency of a leaf set
+    
+    
+    //--------------------------- PRIVATE: enumerate ---------------------------
+    // Take away, or add, the classes of every connected size-k vertex set
+    // holding one of the pairs in the current graph
+    // Preconditions: pairs holds the pairs of the switch
+    // Postconditions: Every such set was counted once, with its first pair
+    void enumerate();
+    
+    //----------------------------- PRIVATE: grow ------------------------------
+    // Grow members[0 .. size-1] by the candidates[begin .. end-1]
+    // Preconditions: size < k; the members are connected and blocked;
+    //                nearest, the least distance of a member to the far
+    //                end, is at most k - size; no slot of candidates from
+    //                end on is in use
+    // Postconditions: Every size-k set extending the members and holding
+    //                 the far end has been counted; candidates[begin ..
+    //                 end-1] are unchanged
+    void grow(const int &size, const int &nearest, const int &begin,
+              const int &end);
+    
+    //----------------------------- PRIVATE: count -----------------------------
+    // Count the full set in members
+    // Preconditions: members holds k vertices forming a connected set with
+    //                the pair target
+    // Postconditions: Its class is counted unless an earlier pair is in it
+    void count();
+    
+    //--------------------------- PRIVATE: block/unblock -----------------------
+    // Mark, or unmark, v and its neighbors as members or adjacent to one
+    // Preconditions: unblock(v) follows a block(v)
+    // Postconditions: blocked[x] counts the members equal or adjacent to x
+    void block(const int &v);
+    void unblock(const int &v);
+    
+    //---------------------------- PRIVATE: replace ----------------------------
+    // Replace neighbor from by to in the row of v
+    // Preconditions: from is in the row of v
+    // Postconditions: to is in the row of v instead
+    void replace(const int &v, const int &from, const int &to);
+};
+
+#endif /* defined(__IncrementalCensus__) */
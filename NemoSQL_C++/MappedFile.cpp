@@ -0,0 +1,133 @@
+//------------------------------------------------------------------------------
+//  MappedFile.cpp
+//------------------------------------------------------------------------------
+// MappedFile is a read-only memory mapping of a whole file. The mapping is
+// released when the object is destroyed, so pointers handed out by data() are
+// only valid for the lifetime of the MappedFile that produced them.
+//
+// ASSUMPTIONS:
+//   -- A POSIX mmap is available
+//   -- A MappedFile is never copied; ownership can only be moved
+//
+//------------------------------------------------------------------------------
+
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//--------------------------- A Default Constructor ----------------------------
+// Default constructor for class MappedFile
+// Preconditions: None
+// Postconditions: Nothing is mapped
+MappedFile::MappedFile(){}
+
+//--------------------------------- Destructor ---------------------------------
+// Destructor for class MappedFile
+// Preconditions: None
+// Postconditions: The mapping, if any, is released
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+//------------------------------- Move Semantics -------------------------------
+// Transfer the mapping from other to this object
+// Preconditions: None
+// Postconditions: other no longer owns a mapping
+MappedFile::MappedFile(MappedFile &&other)
+{
+    *this = static_cast<MappedFile &&>(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other)
+{
+    if (this != &other)
+    {
+        close();
+        bytes = other.bytes;
+        length = other.length;
+        other.bytes = nullptr;
+        other.length = 0;
+    }
+    
+    return *this;
+}
+
+
+//------------------------------------ open ------------------------------------
+// Map the whole file read-only
+// Preconditions: None
+// Postconditions: Returns true if filename was opened and mapped. An empty
+//                 file is opened successfully with size() == 0.
+bool MappedFile::open(const string &filename)
+{
+    close();
+    
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    
+    // mmap rejects zero-length mappings; an empty file simply has no bytes
+    if (info.st_size > 0)
+    {
+        void *mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ,
+                             MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        
+        madvise(mapping, (size_t)info.st_size, MADV_SEQUENTIAL);
+        bytes = static_cast<const char *>(mapping);
+        length = (size_t)info.st_size;
+    }
+    
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    return true;
+}
+
+//------------------------------------ close -----------------------------------
+// Release the mapping
+// Preconditions: None
+// Postconditions: Nothing is mapped
+void MappedFile::close()
+{
+    if (bytes != nullptr)
+        munmap(const_cast<char *>(bytes), length);
+    
+    bytes = nullptr;
+    length = 0;
+}
+
+
+//---------------------------------- fileStamp ---------------------------------
+// Size and last modification time of a file
+// Preconditions: None
+// Postconditions: Returns false if filename could not be examined
+bool MappedFile::fileStamp(const string &filename, uint64_t &bytes,
+                           uint64_t &modified)
+{
+    struct stat info;
+    if (stat(filename.c_str(), &info) != 0)
+        return false;
+    
+#ifdef __APPLE__
+    const struct timespec &time = info.st_mtimespec;
+#else
+    const struct timespec &time = info.st_mtim;
+#endif
+    bytes = (uint64_t)info.st_size;
+    modified = (uint64_t)time.tv_sec * 1000000000 + (uint64_t)time.tv_nsec;
+    return true;
+}
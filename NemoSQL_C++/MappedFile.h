@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------------
+//  MappedFile.h
+//------------------------------------------------------------------------------
+// MappedFile is a read-only memory mapping of a whole file. The mapping is
+// released when the object is destroyed, so pointers handed out by data() are
+// only valid for the lifetime of the MappedFile that produced them.
+//
+// ASSUMPTIONS:
+//   -- A POSIX mmap is available
+//   -- A MappedFile is never copied; ownership can only be moved
+//
+//------------------------------------------------------------------------------
+
+#ifndef __MappedFile__
+#define __MappedFile__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+class MappedFile
+{
+public:
+    
+    //-------------------------- A Default Constructor -------------------------
+    // Default constructor for class MappedFile
+    // Preconditions: None
+    // Postconditions: Nothing is mapped
+    MappedFile();
+    
+    //------------------------------- Destructor -------------------------------
+    // Destructor for class MappedFile
+    // Preconditions: None
+    // Postconditions: The mapping, if any, is released
+    ~MappedFile();
+    
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    
+    //------------------------------ Move Semantics ----------------------------
+    // Transfer the mapping from other to this object
+    // Preconditions: None
+    // Postconditions: other no longer owns a mapping
+    MappedFile(MappedFile &&other);
+    MappedFile &operator=(MappedFile &&other);
+    
+    
+    //---------------------------------- open ----------------------------------
+    // Map the whole file read-only
+    // Preconditions: None
+    // Postconditions: Returns true if filename was opened and mapped. An empty
+    //                 file is opened successfully with size() == 0.
+    bool open(const string &filename);
+    
+    //---------------------------------- close ---------------------------------
+    // Release the mapping
+    // Preconditions: None
+    // Postconditions: Nothing is mapped
+    void close();
+    
+    
+    //------------------------------- data / size ------------------------------
+    // The mapped bytes
+    // Preconditions: None
+    // Postconditions: Returns the first mapped byte and the number of bytes
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+    
+    
+    //------------------------------- fileStamp --------------------------------
+    // Size and last modification time of a file, to tell whether it changed
+    // Preconditions: None
+    // Postconditions: Returns false if filename could not be examined.
+    //                 Otherwise bytes holds its size and modified its
+    //                 modification time in nanoseconds since the epoch.
+    static bool fileStamp(const string &filename, uint64_t &bytes,
+                          uint64_t &modified);
+    
+    
+private:
+    const char *bytes = nullptr;            // start of the mapping
+    size_t length = 0;                      // number of mapped bytes
+};
+
+#endif /* defined(__MappedFile__) */
@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+//  Random.h
+//------------------------------------------------------------------------------
+// Random is a small, fast pseudo random generator (xoshiro256**) for the
+// sampling and randomization code. Every thread owns its own Random, and a
+// generator seeded with the same value always produces the same sequence.
+//
+// ASSUMPTIONS:
+//   -- Statistical quality, not cryptographic strength, is required
+//
+//------------------------------------------------------------------------------
+
+#ifndef __Random__
+#define __Random__
+
+#include <cstdint>
+
+using namespace std;
+
+class Random
+{
+public:
+    
+    //------------------------------- Constructor ------------------------------
+    // Seed the generator
+    // Preconditions: None
+    // Postconditions: The state is expanded from seed with splitmix64
+    explicit Random(uint64_t seed = 0) { reseed(seed); }
+    
+    //--------------------------------- reseed ---------------------------------
+    // Restart the generator from seed
+    // Preconditions: None
+    // Postconditions: The next values are those of Random(seed)
+    void reseed(uint64_t seed)
+    {
+        for (uint64_t &word : state)
+            word = mix(seed += 0x9E3779B97F4A7C15ULL);
+    }
+    
+    //---------------------------------- next ----------------------------------
+    // Next 64 random bits
+    // Preconditions: None
+    // Postconditions: The state advances by one step
+    uint64_t next()
+    {
+        const uint64_t result = rotate(state[1] * 5, 7) * 9;
+        const uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotate(state[3], 45);
+        return result;
+    }
+    
+    //--------------------------------- below ----------------------------------
+    // Uniform integer in 0 .. bound-1
+    // Preconditions: bound > 0
+    // Postconditions: Returns the high word of a 64 x 64 bit product, whose
+    //                 bias is at most bound / 2^64
+    uint64_t below(const uint64_t &bound)
+    {
+        return (uint64_t)(((unsigned __int128)next() * bound) >> 64);
+    }
+    
+    //--------------------------------- uniform --------------------------------
+    // Uniform double in [0, 1)
+    // Preconditions: None
+    // Postconditions: Returns a multiple of 2^-53
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    
+    //------------------------------- threshold --------------------------------
+    // Threshold for chance() that succeeds with probability p
+    // Preconditions: 0 <= p <= 1
+    // Postconditions: Returns the 64-bit threshold of p
+    static uint64_t threshold(const double &p)
+    {
+        if (p >= 1.0)
+            return ~(uint64_t)0;
+        if (p <= 0.0)
+            return 0;
+        return (uint64_t)(p * 18446744073709551616.0);
+    }
+    
+    //--------------------------------- chance ---------------------------------
+    // Bernoulli trial against a value from threshold()
+    // Preconditions: None
+    // Postconditions: Returns true with the probability the threshold encodes
+    bool chance(const uint64_t &limit) { return next() < limit; }
+    
+    //---------------------------------- mix -----------------------------------
+    // splitmix64 finalizer, also usable as a stateless hash
+    // Preconditions: None
+    // Postconditions: Returns a well mixed function of x
+    static uint64_t mix(uint64_t x)
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+    
+    
+private:
+    uint64_t state[4];                      // xoshiro256** state
+    
+    //--------------------------- PRIVATE: rotate ------------------------------
+    // Rotate x left by r bits
+    // Preconditions: 0 < r < 64
+    // Postconditions: Returns the rotated value
+    static uint64_t rotate(const uint64_t &x, const int &r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+};
+
+#endif /* defined(__Random__) */
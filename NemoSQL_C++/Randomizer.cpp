@@ -0,0 +1,143 @@
+//------------------------------------------------------------------------------
+//  Randomizer.cpp
+//------------------------------------------------------------------------------
+// Randomizer runs the edge switching chain on a flat list of edges, checked
+// against an EdgeSet of the same edges. A switch takes two random edges and
+// one random bit, which decides whether a-b and c-d become a-d and c-b or
+// a-c and d-b, so that both rewirings of a pair of edges are equally likely.
+// A switch that would make a loop or an edge already present is rejected
+// and counts as a failed attempt.
+//
+// ASSUMPTIONS:
+//   -- As in Randomizer.h
+//
+//------------------------------------------------------------------------------
+
+#include "Randomizer.h"
+#include <algorithm>
+
+//--------------------------------- Constructor --------------------------------
+// Start a chain at graph
+// Preconditions: None
+// Postconditions: The current graph is a copy of the edges of graph, and
+//                 switches are drawn from a generator seeded with seed
+Randomizer::Randomizer(const Graph &graph, const uint64_t &seed)
+    : random(seed)
+{
+    // Every undirected edge once, from its lower end
+    for (int u = 0; u < graph.vertexCount(); u++)
+        for (const int *p = upper_bound(graph.neighborBegin(u),
+                                        graph.neighborEnd(u), u);
+             p != graph.neighborEnd(u); p++)
+            start.push_back(make_pair(u, *p));
+    
+    edges = start;
+    fillSet();
+}
+
+
+//---------------------------------- setSwaps ----------------------------------
+// Choose the length of a randomize call
+// Preconditions: perEdge >= 0; tries >= 1
+// Postconditions: Later calls to randomize use these values
+void Randomizer::setSwaps(const double &perEdge, const int &tries)
+{
+    swapsPerEdge = perEdge;
+    triesPerSwap = max(1, tries);
+}
+
+//---------------------------------- randomize ---------------------------------
+// Run the chain on from the current graph
+// Preconditions: None
+// Postconditions: Returns the number of switches accepted; the degree of
+//                 every vertex is unchanged
+long Randomizer::randomize()
+{
+    const uint64_t target = (uint64_t)(swapsPerEdge * edges.size() + 0.5);
+    const uint64_t attempts = target * (uint64_t)triesPerSwap;
+    uint64_t accepted = 0;
+    Switch s;
+    for (uint64_t attempt = 0; attempt < attempts && accepted < target;
+         attempt++)
+        if (propose(s))
+        {
+            apply(s);
+            accepted++;
+        }
+    
+    return (long)accepted;
+}
+
+//----------------------------------- propose ----------------------------------
+// Draw one switch at random
+// Preconditions: None
+// Postconditions: Returns false if the draw would make a self loop or an
+//                 edge that exists; otherwise s holds a switch to apply
+bool Randomizer::propose(Switch &s)
+{
+    const uint64_t m = edges.size();
+    if (m < 2)
+        return false;
+    
+    s.first = random.below(m);
+    s.second = random.below(m);
+    if (s.first == s.second)
+        return false;
+    
+    s.a = edges[s.first].first;
+    s.b = edges[s.first].second;
+    s.c = edges[s.second].first;
+    s.d = edges[s.second].second;
+    if (random.next() >> 63)
+        swap(s.c, s.d);
+    
+    // a-b, c-d become a-d, c-b
+    return s.a != s.d && s.c != s.b && !edgeSet.contains(s.a, s.d) &&
+           !edgeSet.contains(s.c, s.b);
+}
+
+//------------------------------------ apply -----------------------------------
+// Make a switch
+// Preconditions: s was returned by propose, and no switch has been applied
+//                since
+// Postconditions: a-b and c-d are replaced by a-d and c-b
+void Randomizer::apply(const Switch &s)
+{
+    edgeSet.erase(s.a, s.b);
+    edgeSet.erase(s.c, s.d);
+    edgeSet.insert(s.a, s.d);
+    edgeSet.insert(s.c, s.b);
+    edges[s.first] = make_pair(s.a, s.d);
+    edges[s.second] = make_pair(s.c, s.b);
+}
+
+//------------------------------------ reset -----------------------------------
+// Return to the graph the chain started at
+// Preconditions: None
+// Postconditions: The current graph is that of the constructor
+void Randomizer::reset()
+{
+    edges = start;
+    fillSet();
+}
+
+//----------------------------------- writeTo ----------------------------------
+// Copy the current graph into the CSR of replicate
+// Preconditions: replicate has the vertices of the graph the chain started at
+// Postconditions: replicate holds the current graph
+void Randomizer::writeTo(Graph &replicate) const
+{
+    replicate.rewire(edges);
+}
+
+
+//------------------------------ PRIVATE: fillSet ------------------------------
+// Rebuild edgeSet from edges
+// Preconditions: None
+// Postconditions: edgeSet holds exactly the edges of edges
+void Randomizer::fillSet()
+{
+    edgeSet.reset(edges.size());
+    for (const pair<int, int> &edge : edges)
+        edgeSet.insert(edge.first, edge.second);
+}
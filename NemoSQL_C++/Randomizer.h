@@ -0,0 +1,133 @@
+//------------------------------------------------------------------------------
+//  Randomizer.h
+//------------------------------------------------------------------------------
+// Randomizer generates random graphs with the degree sequence of a given
+// graph, the null model against which motifs are judged. It runs the edge
+// switching Markov chain: pick two edges a-b and c-d at random and replace
+// them by a-d and c-b, unless that would make a self loop or an edge that
+// already exists. Every vertex keeps its degree, and after a few accepted
+// switches per edge the graph is close to a uniform sample of the simple
+// graphs with that degree sequence.
+//
+// The current graph is kept as a flat list of edges, so that a random edge
+// is a single index, together with an EdgeSet of the same edges, so that a
+// switch is checked for duplicate edges in constant time. writeTo turns the
+// current graph into the CSR of a Graph. A caller that needs to see every
+// switch, such as an IncrementalCensus, drives the chain itself with
+// propose and apply instead of randomize.
+//
+// ASSUMPTIONS:
+//   -- The graph is simple: no self loops, no repeated edges
+//   -- A Randomizer is used by one thread; a parallel ensemble gives every
+//      thread its own, with its own seed
+//
+//------------------------------------------------------------------------------
+
+#ifndef __Randomizer__
+#define __Randomizer__
+
+#include "EdgeSet.h"
+#include "Graph.h"
+#include "Random.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class Randomizer
+{
+public:
+    
+    // A switch of the edges at positions first and second of the edge list,
+    // a-b and c-d, for a-d and c-b
+    struct Switch
+    {
+        size_t first, second;               // positions of a-b and c-d
+        int a, b, c, d;                     // their ends
+    };
+    
+    //------------------------------- Constructor ------------------------------
+    // Start a chain at graph
+    // Preconditions: None
+    // Postconditions: The current graph is a copy of the edges of graph, and
+    //                 switches are drawn from a generator seeded with seed
+    Randomizer(const Graph &graph, const uint64_t &seed = 1);
+    
+    
+    //-------------------------------- setSwaps --------------------------------
+    // Choose the length of a randomize call: perEdge accepted switches for
+    // every edge, giving up after tries attempts per switch
+    // Preconditions: perEdge >= 0; tries >= 1
+    // Postconditions: Later calls to randomize use these values; the
+    //                 default is 3 switches per edge and 3 tries
+    void setSwaps(const double &perEdge, const int &tries = 3);
+    
+    //-------------------------------- randomize -------------------------------
+    // Run the chain on from the current graph
+    // Preconditions: None
+    // Postconditions: Returns the number of switches accepted, which falls
+    //                 short of the target only if the attempts ran out. The
+    //                 degree of every vertex is unchanged.
+    long randomize();
+    
+    //--------------------------------- propose --------------------------------
+    // Draw one switch at random
+    // Preconditions: None
+    // Postconditions: Returns false if the draw would make a self loop or
+    //                 an edge that exists, or there are fewer than two
+    //                 edges; otherwise s holds a switch apply may make
+    bool propose(Switch &s);
+    
+    //---------------------------------- apply ---------------------------------
+    // Make a switch
+    // Preconditions: s was returned by propose, and no switch has been
+    //                applied since
+    // Postconditions: a-b and c-d are replaced by a-d and c-b
+    void apply(const Switch &s);
+    
+    //---------------------------------- reset ---------------------------------
+    // Return to the graph the chain started at
+    // Preconditions: None
+    // Postconditions: The current graph is that of the constructor; the
+    //                 generator is not reseeded
+    void reset();
+    
+    //---------------------------------- reseed --------------------------------
+    // Restart the generator
+    // Preconditions: None
+    // Postconditions: Switches are drawn as from a new Randomizer with seed
+    void reseed(const uint64_t &seed) { random.reseed(seed); }
+    
+    //--------------------------------- writeTo --------------------------------
+    // Copy the current graph into the CSR of replicate
+    // Preconditions: replicate has the vertices of the graph the chain
+    //                started at, e.g. it is that graph or a copy of it
+    // Postconditions: replicate holds the current graph, with the original
+    //                 IDs of its vertices (see Graph::rewire)
+    void writeTo(Graph &replicate) const;
+    
+    //------------------------------- edgeCount --------------------------------
+    // Number of edges of the current graph
+    // Preconditions: None
+    // Postconditions: Returns the number of edges of the starting graph
+    size_t edgeCount() const { return edges.size(); }
+    
+    
+private:
+    vector<pair<int, int>> start;           // edges of the starting graph
+    vector<pair<int, int>> edges;           // edges of the current graph
+    EdgeSet edgeSet;                        // the same edges, for lookups
+    Random random;                          // draws the switches
+    double swapsPerEdge = 3.0;              // see setSwaps
+    int triesPerSwap = 3;                   // see setSwaps
+    
+    
+    //---------------------------- PRIVATE: fillSet ----------------------------
+    // Rebuild edgeSet from edges
+    // Preconditions: None
+    // Postconditions: edgeSet holds exactly the edges of edges
+    void fillSet();
+};
+
+#endif /* defined(__Randomizer__) */
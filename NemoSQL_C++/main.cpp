@@ -9,12 +9,51 @@
 //   -- the "input.txt" text file must exist in the same directory as this
 //      programand, and it must be formatted as described in the specifications
 //      stated in Graph.h
+//
+// Options:
+//   --size K             count subgraphs of K vertices (default 5, at least 2)
+//   --threads N          enumerate on N worker threads (default 1)
+//   --relabel ORDER      renumber the vertices before counting, by degree
+//                        ("degree") or breadth first ("bfs"); the counts
+//                        are the same, only the spread of the work changes
+//   --classify           count every isomorphism class too, with nauty
+//   --class-cache FILE   with --classify and K of 7 or 8, load the canonical
+//                        form cache from FILE if it exists and save it after
+//   --sample p1,...,pk   estimate the count with RAND-ESU, keeping a tree node
+//                        whose subgraph has s vertices with probability ps
+//   --budget-seconds S   stop after S seconds and estimate what is left
+//   --budget-nodes N     stop after N ESU tree nodes and estimate what is left
+//   --checkpoint FILE    save progress to FILE every 600 seconds, resuming
+//                        from FILE first if it exists, which must then
+//                        match the graph, K and --classify
+//   --checkpoint-every S save progress every S seconds instead
+//   --randomize Q        count in a random graph with the degrees of the
+//                        input instead, made with Q edge switches per edge
+//   --ensemble N         compare the classes of the input with those of N
+//                        random graphs with its degrees, each made with the
+//                        Q of --randomize (default 3), and report z-scores
+//                        and p-values; the ensemble always classifies
+//                        exactly and to the end, so it takes none of
+//                        --classify, --sample, --budget-* and --checkpoint
+//   --ensemble-width W   with --ensemble, stop early once the 95% interval
+//                        of every z-score is narrower than W or clear of
+//                        the threshold, checking every 25 random graphs
+//   --ensemble-z Z       the threshold for --ensemble-width (default 2)
+//   --seed S             seed the random generators with S (default 1)
 //------------------------------------------------------------------------------
 
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <sstream>
+#include <vector>
 #include "Graph.h"
+#include "Census.h"
+#include "Ensemble.h"
+#include "Randomizer.h"
 
 using namespace std;
 
@@ -24,22 +63,211 @@ using namespace std;
 //                  in the specifications stated in Graph.h
 // Postconditions:  - The graph of the input will be generated
 //                  - The k-size subgraphs with be generated as called
-int main() {
-    ifstream infile1("/Users/shokorakis/Desktop/Homework_3/Homework_3/input/Ecoli20111027CR_idx.txt");
-    if (!infile1) {
-        cerr << "File could not be opened." << endl;
+//                  - A binary snapshot of the input is kept next to it, so
+//                    later runs map the snapshot instead of parsing the
+//                    text, until the text is changed
+int main(int argc, char *argv[]) {
+    int k = 5;
+    int threads = 1;
+    string relabel;
+    bool classify = false;
+    string classCache;
+    vector<double> probabilities;
+    double budgetSeconds = 0.0;
+    long budgetNodes = 0;
+    string checkpoint;
+    double checkpointEvery = 600.0;
+    double swaps = 0.0;
+    int ensemble = 0;
+    double ensembleWidth = 0.0;
+    double ensembleZ = 2.0;
+    uint64_t seed = 1;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+            k = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--relabel") == 0 && i + 1 < argc)
+            relabel = argv[++i];
+        else if (strcmp(argv[i], "--classify") == 0)
+            classify = true;
+        else if (strcmp(argv[i], "--class-cache") == 0 && i + 1 < argc)
+            classCache = argv[++i];
+        else if (strcmp(argv[i], "--sample") == 0 && i + 1 < argc) {
+            // p[0] is unused so that p[s] belongs to subgraphs of size s
+            probabilities.assign(1, 1.0);
+            stringstream list(argv[++i]);
+            string p;
+            while (getline(list, p, ',')) {
+                // A token that does not parse in full is stored as 0, which
+                // the range check below rejects
+                char *end = nullptr;
+                const double value = strtod(p.c_str(), &end);
+                const bool parsed = end != p.c_str() && *end == '\0';
+                probabilities.push_back(parsed ? value : 0.0);
+            }
+        }
+        else if (strcmp(argv[i], "--budget-seconds") == 0 && i + 1 < argc)
+            budgetSeconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--budget-nodes") == 0 && i + 1 < argc)
+            budgetNodes = atol(argv[++i]);
+        else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+            checkpoint = argv[++i];
+        else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc)
+            checkpointEvery = atof(argv[++i]);
+        else if (strcmp(argv[i], "--randomize") == 0 && i + 1 < argc)
+            swaps = atof(argv[++i]);
+        else if (strcmp(argv[i], "--ensemble") == 0 && i + 1 < argc)
+            ensemble = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ensemble-width") == 0 && i + 1 < argc)
+            ensembleWidth = atof(argv[++i]);
+        else if (strcmp(argv[i], "--ensemble-z") == 0 && i + 1 < argc)
+            ensembleZ = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], nullptr, 10);
+        else {
+            cerr << "Usage: " << argv[0]
+                 << " [--size K] [--threads N] [--relabel degree|bfs]"
+                 << " [--classify]"
+                 << " [--class-cache FILE]"
+                 << " [--sample p1,...,pk]"
+                 << " [--budget-seconds S] [--budget-nodes N]"
+                 << " [--checkpoint FILE] [--checkpoint-every S]"
+                 << " [--randomize Q] [--ensemble N]"
+                 << " [--ensemble-width W] [--ensemble-z Z] [--seed S]"
+                 << endl;
+            return 1;
+        }
+    }
+    
+    if (k < 2) {
+        cerr << "--size needs at least 2 vertices." << endl;
+        return 1;
+    }
+    if (!relabel.empty() && relabel != "degree" && relabel != "bfs") {
+        cerr << "--relabel needs degree or bfs." << endl;
+        return 1;
+    }
+    if (classify && k > Classifier::MAX_SIZE) {
+        cerr << "--classify supports at most " << Classifier::MAX_SIZE
+             << " vertices." << endl;
+        return 1;
+    }
+    if (!classCache.empty() && (!classify ||
+        k <= Classifier::TABLE_SIZE || k > Classifier::CACHE_SIZE)) {
+        cerr << "--class-cache needs --classify and K of 7 or 8." << endl;
+        return 1;
+    }
+    if (!probabilities.empty() && (int)probabilities.size() != k + 1) {
+        cerr << "--sample needs " << k << " probabilities." << endl;
+        return 1;
+    }
+    for (size_t s = 1; s < probabilities.size(); s++)
+        if (!(probabilities[s] > 0.0 && probabilities[s] <= 1.0)) {
+            cerr << "--sample needs probabilities in (0, 1]." << endl;
+            return 1;
+        }
+    if (checkpointEvery <= 0.0) {
+        cerr << "--checkpoint-every needs a positive interval." << endl;
+        return 1;
+    }
+    if (swaps < 0.0) {
+        cerr << "--randomize needs a non-negative number of switches."
+             << endl;
+        return 1;
+    }
+    if (ensemble < 0 || (ensemble > 0 && k > Classifier::MAX_SIZE)) {
+        cerr << "--ensemble needs a non-negative count and at most "
+             << Classifier::MAX_SIZE << " vertices." << endl;
+        return 1;
+    }
+    if (ensemble > 0 && (classify || !probabilities.empty() ||
+        budgetSeconds > 0.0 || budgetNodes > 0 || !checkpoint.empty())) {
+        cerr << "--ensemble cannot be combined with --classify, --sample,"
+             << " --budget-seconds, --budget-nodes or --checkpoint." << endl;
+        return 1;
+    }
+    if (ensembleWidth < 0.0 || ensembleZ < 0.0) {
+        cerr << "--ensemble-width and --ensemble-z need non-negative values."
+             << endl;
         return 1;
     }
     
+    string input = "/Users/shokorakis/Desktop/Homework_3/Homework_3/input/Ecoli20111027CR_idx.txt";
+    string snapshot = input + ".csr";
+    
     Graph G;
-    G.buildGraph(infile1);
-    //infile1.close();
+    if (!G.loadSnapshot(snapshot, input)) {
+        if (!G.buildGraph(input, threads)) {
+            cerr << "File could not be opened, or holds a vertex ID that "
+                 << "is negative or above " << INT_MAX << "." << endl;
+            return 1;
+        }
+        G.writeSnapshot(snapshot, input);
+    }
+    if (!relabel.empty())
+        G.relabel(relabel == "degree" ? Graph::DEGREE_ORDER
+                                      : Graph::BFS_ORDER);
+    
+    if (ensemble > 0) {
+        auto start = chrono::high_resolution_clock::now();
+        G.buildEdgeIndex();
+        Ensemble significance(G, k, threads);
+        if (swaps > 0.0)
+            significance.setSwaps(swaps);
+        significance.setSeed(seed);
+        if (ensembleWidth > 0.0)
+            significance.setStopping(ensembleWidth, ensembleZ);
+        significance.run(ensemble);
+        significance.display();
+        
+        auto end = chrono::high_resolution_clock::now();
+        cout << "Run Time = " << chrono::duration_cast<chrono::milliseconds>(
+            end - start).count() << endl;
+        return 0;
+    }
+    
+    if (swaps > 0.0) {
+        Randomizer randomizer(G, seed);
+        randomizer.setSwaps(swaps);
+        const long accepted = randomizer.randomize();
+        randomizer.writeTo(G);
+        cerr << "Randomized with " << accepted << " edge switches" << endl;
+    }
     
     //G.displayAll();
     auto start = chrono::high_resolution_clock::now();
-    //G.enumerateSubgraph(3);
-    //G.enumerateSubgraph(4);
-    G.enumerateSubgraph(5);
+    Census census(G, k, threads);
+    if (classify) {
+        G.buildEdgeIndex();
+        census.setClassification();
+        // A missing cache is written at the end, and so is a bad one, which
+        // is ignored
+        if (!classCache.empty() && Classifier::loadCache(classCache, k))
+            cerr << "Loaded " << classCache << endl;
+        else if (!classCache.empty() && ifstream(classCache.c_str()))
+            cerr << "Ignoring " << classCache
+                 << ", which is not a valid class cache for K." << endl;
+    }
+    if (!probabilities.empty())
+        census.setSampling(probabilities, seed);
+    census.setBudget(budgetSeconds, budgetNodes);
+    if (!checkpoint.empty()) {
+        census.setCheckpoint(checkpoint, checkpointEvery);
+        if (census.resume(checkpoint))
+            cerr << "Resuming from " << checkpoint << endl;
+        else if (ifstream(checkpoint.c_str())) {
+            // Starting over would overwrite progress saved for another run
+            cerr << checkpoint << " does not match this graph, size and"
+                 << " --classify setting." << endl;
+            return 1;
+        }
+    }
+    census.run();
+    census.display();
+    if (!classCache.empty() && !Classifier::saveCache(classCache, k))
+        cerr << "Could not save " << classCache << endl;
     
     auto end = chrono::high_resolution_clock::now();
     auto timeInSec = end - start;
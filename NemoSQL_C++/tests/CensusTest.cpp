@@ -0,0 +1,257 @@
+//------------------------------------------------------------------------------
+//  CensusTest.cpp
+//------------------------------------------------------------------------------
+// Checks that a census stopped by its budget and resumed from its checkpoint
+// until it completes finds exactly what an uninterrupted census finds, on a
+// graph with one hub whose ESU tree is far larger than the budget, and that
+// resume rejects inconsistent or mismatched checkpoints. Also checks the
+// class variance of a sampled census against its closed form.
+//
+// Build and run from NemoSQL_C++, with nauty as for main.cpp:
+//   g++ -O2 -std=c++17 -pthread -I. -I<nauty> tests/CensusTest.cpp
+//       Census.cpp Classifier.cpp ESUEngine.cpp Graph.cpp GraphCodec.cpp
+//       MappedFile.cpp <nauty>/nautyL1.a -o CensusTest && ./CensusTest
+//
+// ASSUMPTIONS:
+//   -- The current directory is writable
+//
+//------------------------------------------------------------------------------
+
+#include "Census.h"
+#include "Graph.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+static int failures = 0;
+
+//------------------------------------ check -----------------------------------
+// Report a failed expectation
+// Preconditions: None
+// Postconditions: failures has grown by one if ok is false
+static void check(const bool &ok, const string &what)
+{
+    if (!ok)
+    {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+//---------------------------------- hubGraph ----------------------------------
+// A 300-vertex graph: a ring with chords, and vertex 0 joined to every other
+// Preconditions: None
+// Postconditions: Returns whether graph was loaded; graph holds it if so
+static bool hubGraph(Graph &graph)
+{
+    const char *file = "CensusTest.txt";
+    {
+        ofstream edges(file);
+        for (int v = 1; v < 300; v++)
+        {
+            edges << 0 << " " << v << "\n";
+            edges << v << " " << v % 299 + 1 << "\n";
+            edges << v << " " << (v * 7 + 3) % 299 + 1 << "\n";
+        }
+    }
+    const bool loaded = graph.buildGraph(string(file));
+    remove(file);
+    return loaded;
+}
+
+//------------------------------ resumedCensus ---------------------------------
+// Run a census under a node budget, resuming from its checkpoint after every
+// stop, until it completes
+// Preconditions: nodes > 0
+// Postconditions: total and classes hold what the final run found; rounds
+//                 holds the runs it took, or 1001 if it never completed
+static void resumedCensus(const Graph &graph, const int &k,
+                          const int &threads, const long &nodes,
+                          const double &every, const bool &classify,
+                          Counter &total, ClassCounts &classes, int &rounds)
+{
+    const char *file = "CensusTest.ckp";
+    remove(file);
+    for (rounds = 1; rounds <= 1000; rounds++)
+    {
+        Census census(graph, k, threads);
+        if (classify)
+            census.setClassification();
+        census.setBudget(0.0, nodes);
+        census.setCheckpoint(file, every);
+        census.resume(file);
+        census.run();
+        if (census.complete())
+        {
+            total = census.total();
+            classes = census.classCounts();
+            return;
+        }
+    }
+    remove(file);
+}
+
+//----------------------------------- main -------------------------------------
+int main()
+{
+    Graph graph;
+    check(hubGraph(graph), "hub graph loads");
+    graph.buildEdgeIndex();
+    
+    // Both loaders reject a negative vertex ID
+    {
+        const char *bad = "CensusTest.txt";
+        {
+            ofstream edges(bad);
+            edges << "1 2\n-3 4\n";
+        }
+        Graph rejected;
+        ifstream infile(bad);
+        check(!rejected.buildGraph(infile), "stream loader rejects -3");
+        check(!rejected.buildGraph(string(bad)), "mapped loader rejects -3");
+        remove(bad);
+    }
+    const int k = 4;
+    
+    Census whole(graph, k, 1);
+    whole.setClassification();
+    whole.run();
+    check(whole.complete(), "uninterrupted census completes");
+    
+    // A second run reuses the engines and per-root arrays of the first
+    const Counter first = whole.total();
+    const ClassCounts firstClasses = whole.classCounts();
+    whole.run();
+    check(whole.total() == first && whole.classCounts() == firstClasses,
+          "a census run again finds the same");
+    
+    // Sampling only the leaves draws each one on its own, so the variance
+    // of every class is its count times (1 - p) / p^2
+    {
+        vector<double> p(k + 1, 1.0);
+        p[k] = 0.5;
+        Census sampled(graph, k, 2);
+        sampled.setClassification();
+        sampled.setSampling(p, 7);
+        sampled.run();
+        for (const pair<const ClassKey, Counter> &entry :
+             sampled.classCounts())
+        {
+            const double expected = entry.second.value() * 2.0;
+            check(fabs(sampled.classVariance(entry.first) - expected) <=
+                  1e-9 * expected, "class variance of sampled leaves");
+        }
+        check(!sampled.classCounts().empty(), "sampled classes found");
+    }
+    
+    // Budgets far below the hub's ESU tree, with and without checkpoints
+    // taken in the middle of the runs
+    const int threadCounts[] = {1, 4};
+    const long budgets[] = {20000, 100000, 300000};
+    for (int threads : threadCounts)
+        for (long nodes : budgets)
+            for (double every : {600.0, 0.001})
+            {
+                Counter total;
+                ClassCounts classes;
+                int rounds = 0;
+                resumedCensus(graph, k, threads, nodes, every, true, total,
+                              classes, rounds);
+                const string run = to_string(threads) + " threads, " +
+                                   to_string(nodes) + " nodes, every " +
+                                   to_string(every) + " s";
+                check(rounds <= 1000, "resumed census completes: " + run);
+                check(total == whole.total(), "resumed total: " + run);
+                check(classes == whole.classCounts(),
+                      "resumed classes: " + run);
+            }
+    
+    // Leave a checkpoint of a stopped, non-classifying run behind
+    const char *file = "CensusTest.ckp";
+    remove(file);
+    {
+        Census stopped(graph, k, 1);
+        stopped.setBudget(0.0, 20000);
+        stopped.setCheckpoint(file, 600.0);
+        stopped.run();
+        check(!stopped.complete(), "budget stops the census");
+    }
+    {
+        Census classifying(graph, k, 1);
+        classifying.setClassification();
+        check(!classifying.resume(file), "classification mismatch rejected");
+        Census plain(graph, k, 1);
+        check(plain.resume(file), "matching checkpoint accepted");
+    }
+    
+    // Corrupt the checkpoint: its header, sampling settings and per-root
+    // arrays come first, then the carries and classes, here empty
+    const int n = graph.vertexCount();
+    const long tasksLeftAt = 28 + 1 + 8 + (k + 1) * 8 + 8;
+    const long firstTaskAt = tasksLeftAt + n * 4L + n * 8L + 8 + 1 + 8 + 8;
+    auto patched = [&](const long &at, const int32_t &value)
+    {
+        fstream checkpoint(file, ios::in | ios::out | ios::binary);
+        int32_t before = 0;
+        checkpoint.seekg(at);
+        checkpoint.read(reinterpret_cast<char *>(&before), sizeof(before));
+        checkpoint.seekp(at);
+        checkpoint.write(reinterpret_cast<const char *>(&value),
+                         sizeof(value));
+        checkpoint.close();
+    
+        Census census(graph, k, 1);
+        const bool accepted = census.resume(file);
+    
+        checkpoint.open(file, ios::in | ios::out | ios::binary);
+        checkpoint.seekp(at);
+        checkpoint.write(reinterpret_cast<const char *>(&before),
+                         sizeof(before));
+        return accepted;
+    };
+    check(!patched(firstTaskAt + 4, -1), "negative branches rejected");
+    check(!patched(tasksLeftAt, 7), "mismatched task counter rejected");
+    check(!patched(tasksLeftAt, -1), "negative task counter rejected");
+    
+    // Corrupt the candidates of the stopped root's subtree tasks: repeat one,
+    // and make one a member of the subgraph already
+    auto field = [&](const long &at)
+    {
+        ifstream checkpoint(file, ios::binary);
+        int32_t value = 0;
+        checkpoint.seekg(at);
+        checkpoint.read(reinterpret_cast<char *>(&value), sizeof(value));
+        return value;
+    };
+    long wide = -1, deep = -1;              // first candidate of each
+    int32_t member = -1;
+    long at = firstTaskAt;
+    for (int32_t task = field(firstTaskAt - 8); task > 0; task--)
+    {
+        const int32_t prefix = field(at + 8), tail = field(at + 12);
+        const long candidates = at + 16 + 4L * prefix;
+        if (wide < 0 && tail >= 2)
+            wide = candidates;
+        if (deep < 0 && prefix > 0 && tail > 0)
+        {
+            deep = candidates;
+            member = field(at + 16);
+        }
+        at = candidates + 4L * tail;
+    }
+    check(wide >= 0 && deep >= 0, "stopped root left subtree tasks");
+    if (wide >= 0)
+        check(!patched(wide + 4, field(wide)), "repeated candidate rejected");
+    if (deep >= 0)
+        check(!patched(deep, member), "member as candidate rejected");
+    Census intact(graph, k, 1);
+    check(intact.resume(file), "restored checkpoint accepted");
+    remove(file);
+    
+    if (failures == 0)
+        cout << "CensusTest passed" << endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------
+//  GraphCodecTest.cpp
+//------------------------------------------------------------------------------
+// Checks GraphCodec against strings written by the gtools of nauty (ntog6,
+// ntod6 and ntos6), the examples of nauty's formats.txt: each graph encodes
+// to its string, and the string decodes back to the graph.
+//
+// Build and run from NemoSQL_C++:
+//   g++ -O2 -std=c++17 -I. tests/GraphCodecTest.cpp GraphCodec.cpp
+//       -o GraphCodecTest && ./GraphCodecTest
+//
+//------------------------------------------------------------------------------
+
+#include "GraphCodec.h"
+#include <iostream>
+
+using namespace std;
+
+static int failures = 0;
+
+//------------------------------------ check -----------------------------------
+// Report a failed expectation
+// Preconditions: None
+// Postconditions: failures has grown by one if ok is false
+static void check(const bool &ok, const string &what)
+{
+    if (!ok)
+    {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+//------------------------------------ rows ------------------------------------
+// Matrix of a graph on at most 64 vertices, in the layout of GraphCodec.h
+// Preconditions: Every arc joins vertices below n <= 64
+// Postconditions: Returns the rows, with both directions of every arc set
+//                 unless directed
+static vector<uint64_t> rows(const int &n,
+                             const vector<pair<int, int>> &arcs,
+                             const bool &directed)
+{
+    vector<uint64_t> matrix(n, 0);
+    for (const pair<int, int> &arc : arcs)
+    {
+        matrix[arc.first] |= (uint64_t)1 << arc.second;
+        if (!directed)
+            matrix[arc.second] |= (uint64_t)1 << arc.first;
+    }
+    return matrix;
+}
+
+//----------------------------------- main -------------------------------------
+int main()
+{
+    // graph6: the Petersen graph
+    vector<pair<int, int>> petersen;
+    for (int i = 0; i < 5; i++)
+    {
+        petersen.push_back(make_pair(i, (i + 1) % 5));
+        petersen.push_back(make_pair(i, i + 5));
+        petersen.push_back(make_pair(i + 5, (i + 2) % 5 + 5));
+    }
+    const vector<uint64_t> graph = rows(10, petersen, false);
+    string out;
+    GraphCodec::encodeGraph6(graph.data(), 10, out);
+    check(out == "IheA@GUAo", "graph6 of the Petersen graph: " + out);
+    int n = 0;
+    vector<uint64_t> back;
+    check(GraphCodec::decode("IheA@GUAo", n, back) && n == 10 &&
+          back == graph, "graph6 decodes to the Petersen graph");
+    
+    // digraph6: arcs 0->2, 0->4, 3->1 and 3->4 on 5 vertices
+    const vector<uint64_t> digraph =
+        rows(5, {{0, 2}, {0, 4}, {3, 1}, {3, 4}}, true);
+    out.clear();
+    GraphCodec::encodeDigraph6(digraph.data(), 5, out);
+    check(out == "&DI?AO?", "digraph6 of the digraph: " + out);
+    check(GraphCodec::decode("&DI?AO?", n, back) && n == 5 &&
+          back == digraph, "digraph6 decodes to the digraph");
+    
+    // sparse6: a triangle and a separate edge on 7 vertices, given in any
+    // order and direction, and with repeats, which ntos6 cannot see
+    const vector<pair<int, int>> edges = {{0, 1}, {0, 2}, {1, 2}, {5, 6}};
+    out.clear();
+    GraphCodec::encodeSparse6(7, edges, out);
+    check(out == ":Fa@x^", "sparse6 of the triangle and edge: " + out);
+    out.clear();
+    GraphCodec::encodeSparse6(7, {{6, 5}, {1, 0}, {2, 1}, {0, 2}, {0, 1},
+                                  {5, 6}}, out);
+    check(out == ":Fa@x^", "sparse6 of the repeated edges: " + out);
+    vector<pair<int, int>> list;
+    check(GraphCodec::decodeSparse6(":Fa@x^", n, list) && n == 7 &&
+          list == edges, "sparse6 decodes to the triangle and edge");
+    check(GraphCodec::decode(":Fa@x^", n, back) && n == 7 &&
+          back == rows(7, edges, false), "sparse6 decodes to a matrix");
+    
+    // sparse6 with a loop: the path 0-1-2-3 and a loop at 3
+    const vector<pair<int, int>> path = {{0, 1}, {1, 2}, {2, 3}, {3, 3}};
+    out.clear();
+    GraphCodec::encodeSparse6(4, path, out);
+    check(out == ":Cdr", "sparse6 of the path with a loop: " + out);
+    check(GraphCodec::decodeSparse6(":Cdr", n, list) && n == 4 &&
+          list == path, "sparse6 decodes to the path with a loop");
+    
+    if (failures == 0)
+        cout << "GraphCodecTest passed" << endl;
+    return failures == 0 ? 0 : 1;
+}
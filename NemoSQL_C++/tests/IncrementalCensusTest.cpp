@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+//  IncrementalCensusTest.cpp
+//------------------------------------------------------------------------------
+// Checks that an IncrementalCensus following a seeded Randomizer chain holds
+// the counts of a whole new Census of the graph the chain ends on, and that
+// swapEdges refuses a switch of a missing edge, to an existing edge or to a
+// loop without changing the counts.
+//
+// Build and run from NemoSQL_C++, with nauty as for main.cpp:
+//   g++ -O2 -std=c++17 -pthread -I. -I<nauty> tests/IncrementalCensusTest.cpp
+//       IncrementalCensus.cpp Randomizer.cpp Census.cpp Classifier.cpp
+//       ESUEngine.cpp Graph.cpp GraphCodec.cpp MappedFile.cpp
+//       <nauty>/nautyL1.a -o IncrementalCensusTest && ./IncrementalCensusTest
+//
+// ASSUMPTIONS:
+//   -- The current directory is writable
+//
+//------------------------------------------------------------------------------
+
+#include "Census.h"
+#include "Graph.h"
+#include "IncrementalCensus.h"
+#include "Randomizer.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+static int failures = 0;
+
+//------------------------------------ check -----------------------------------
+// Report a failed expectation
+// Preconditions: None
+// Postconditions: failures has grown by one if ok is false
+static void check(const bool &ok, const string &what)
+{
+    if (!ok)
+    {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+//--------------------------------- ringGraph ----------------------------------
+// A 40-vertex ring, each vertex also joined to the one opposite it
+// Preconditions: None
+// Postconditions: Returns whether graph was loaded; graph holds it if so,
+//                 with the IDs of the file, since all of 0 .. 39 appear
+static bool ringGraph(Graph &graph)
+{
+    const char *file = "IncrementalCensusTest.txt";
+    {
+        ofstream edges(file);
+        for (int v = 0; v < 40; v++)
+        {
+            edges << v << " " << (v + 1) % 40 << "\n";
+            if (v < 20)
+                edges << v << " " << v + 20 << "\n";
+        }
+    }
+    const bool loaded = graph.buildGraph(string(file));
+    remove(file);
+    return loaded;
+}
+
+//----------------------------------- main -------------------------------------
+int main()
+{
+    Graph graph;
+    check(ringGraph(graph), "ring graph loads");
+    check(graph.vertexCount() == 40, "ring graph has 40 vertices");
+    
+    for (int k = 3; k <= 5; k++)
+    {
+        const string size = "k = " + to_string(k);
+        IncrementalCensus counts(graph, k);
+        const Counter total = counts.total();
+        const ClassCounts classes = counts.classCounts();
+        auto unchanged = [&]()
+        {
+            return counts.total() == total && counts.classCounts() == classes;
+        };
+    
+        // 0-2 is no edge; 0-20 and 21-1 are edges already; d = a or c = b
+        // is a loop
+        check(!counts.swapEdges(0, 2, 5, 6) && unchanged(),
+              "missing edge refused: " + size);
+        check(!counts.swapEdges(0, 1, 19, 20) && unchanged(),
+              "existing edge a-d refused: " + size);
+        check(!counts.swapEdges(0, 1, 21, 22) && unchanged(),
+              "existing edge c-b refused: " + size);
+        check(!counts.swapEdges(0, 1, 39, 0) && unchanged(),
+              "loop a-d refused: " + size);
+        check(!counts.swapEdges(0, 1, 1, 2) && unchanged(),
+              "loop c-b refused: " + size);
+    
+        // A switch and its reverse give back the counts of the start
+        check(counts.swapEdges(0, 1, 5, 6), "valid switch accepted: " + size);
+        check(counts.swapEdges(0, 6, 5, 1) && unchanged(),
+              "reversed switch restores the counts: " + size);
+    
+        // A few switches of a seeded chain, then many, each against a recount
+        Randomizer randomizer(graph, 11 + k);
+        long followed = 0;
+        for (long switches : {5L, 200L})
+        {
+            followed += counts.follow(randomizer, switches);
+            Graph replicate(graph);
+            randomizer.writeTo(replicate);
+            replicate.buildEdgeIndex();
+            Census census(replicate, k, 1);
+            census.setClassification();
+            census.run();
+            const string run = size + ", " + to_string(followed) +
+                               " switches";
+            check(counts.total() == census.total(), "total: " + run);
+            check(counts.classCounts() == census.classCounts(),
+                  "classes: " + run);
+        }
+        check(followed > 5, "chain accepted switches: " + size);
+    }
+    
+    if (failures == 0)
+        cout << "IncrementalCensusTest passed" << endl;
+    return failures == 0 ? 0 : 1;
+}